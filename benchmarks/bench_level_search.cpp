@@ -0,0 +1,122 @@
+#include "order_book.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <random>
+
+/**
+ * Compares the level search used by the order book against std::lower_bound
+ * over the previous vector<pair<Price, Level>> layout for books with 1k to 100k levels
+ * -> Arg(0) number of price levels
+ * -> Arg(1) SimdLevel used by LowerBound/SweepVolume
+ */
+
+namespace
+{
+    constexpr size_t kProbes = 1024;
+
+    std::vector<Price> MakePrices(size_t count)
+    {
+        std::vector<Price> prices(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            prices[i] = 100.0 + i * 0.01;
+        }
+        return prices;
+    }
+
+    std::vector<Price> MakeProbes(const std::vector<Price>& prices)
+    {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<size_t> dist(0, prices.size() - 1);
+        std::vector<Price> probes(kProbes);
+        for (auto& probe : probes)
+        {
+            probe = prices[dist(rng)];
+        }
+        return probes;
+    }
+
+    bool SetupSimdLevel(benchmark::State& state)
+    {
+        auto simdLevel = static_cast<SimdLevel>(state.range(1));
+        if (!SetSimdLevel(simdLevel))
+        {
+            state.SkipWithError("SIMD level not supported on this CPU");
+            return false;
+        }
+        return true;
+    }
+
+    void LevelArgs(benchmark::internal::Benchmark* bench)
+    {
+        for (int64_t count : { 1000, 10000, 100000 })
+        {
+            for (auto simdLevel : { SimdLevel::Scalar, SimdLevel::Avx2 })
+            {
+                bench->Args({ count, static_cast<int64_t>(simdLevel) });
+            }
+        }
+    }
+}
+
+static void BM_PairLowerBound(benchmark::State& state)
+{
+    auto prices = MakePrices(state.range(0));
+    auto probes = MakeProbes(prices);
+    // same footprint as the old level entries without reserving orders for every level
+    std::vector<std::pair<Price, std::array<char, sizeof(Level)>>> levels;
+    levels.reserve(prices.size());
+    for (auto price : prices)
+    {
+        levels.push_back({ price, {} });
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        Price price = probes[i++ % kProbes];
+        auto it = std::lower_bound(levels.begin(), levels.end(), price, [](const auto& level, Price price)
+        {
+            return BidComparator(level.first, price);
+        });
+        benchmark::DoNotOptimize(it);
+    }
+}
+BENCHMARK(BM_PairLowerBound)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_LowerBound(benchmark::State& state)
+{
+    if (!SetupSimdLevel(state))
+    {
+        return;
+    }
+    auto prices = MakePrices(state.range(0));
+    auto probes = MakeProbes(prices);
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(LowerBound(prices.data(), prices.size(), probes[i++ % kProbes], Side::Bid));
+    }
+    SetSimdLevel(GetSupportedSimdLevel());
+}
+BENCHMARK(BM_LowerBound)->Apply(LevelArgs);
+
+static void BM_SweepVolume(benchmark::State& state)
+{
+    if (!SetupSimdLevel(state))
+    {
+        return;
+    }
+    auto prices = MakePrices(state.range(0));
+    auto probes = MakeProbes(prices);
+    std::vector<Volume> volumes(prices.size(), 100);
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(SweepVolume(prices.data(), volumes.data(), prices.size(), probes[i++ % kProbes], Side::Bid));
+    }
+    SetSimdLevel(GetSupportedSimdLevel());
+}
+BENCHMARK(BM_SweepVolume)->Apply(LevelArgs);
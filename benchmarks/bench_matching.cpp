@@ -0,0 +1,35 @@
+#include "order_book.h"
+#include <benchmark/benchmark.h>
+#include <iostream>
+
+/**
+ * Cost of each matching policy for one resting level
+ * -> Arg(0) number of resting orders on the level
+ * -> every iteration rests Arg(0) asks, matches a bid for half of the level
+ *    (policy specific allocation) and a bid for the rest (whole level)
+ */
+
+template<class Book>
+static void BM_MatchLevel(benchmark::State& state)
+{
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    const int64_t orders = state.range(0);
+    Book orderBook;
+    for (auto _ : state)
+    {
+        Volume levelVolume = 0;
+        for (int64_t i = 0; i < orders; ++i)
+        {
+            Volume volume = 10 + i % 7;
+            orderBook.AddOrder(Side::Ask, 100.0, volume);
+            levelVolume += volume;
+        }
+        orderBook.AddOrder(Side::Bid, 100.0, levelVolume / 2);
+        orderBook.AddOrder(Side::Bid, 100.0, levelVolume - levelVolume / 2);
+    }
+    std::cout.rdbuf(coutBuffer);
+    state.SetItemsProcessed(state.iterations() * orders);
+}
+BENCHMARK_TEMPLATE(BM_MatchLevel, OrderBook)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_MatchLevel, ProRataOrderBook)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_MatchLevel, TopOrderProRataOrderBook)->Arg(10)->Arg(100)->Arg(1000);
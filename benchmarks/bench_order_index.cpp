@@ -0,0 +1,73 @@
+#include "order_index.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+/**
+ * Compares OrderMap and OrderTable under a sliding window of live orders
+ * -> ids are handed out sequentially like OrderBook::AddOrder does
+ * -> every iteration adds the newest id, looks up a random live id and
+ *    retires the oldest id, keeping Arg(0) orders live
+ */
+
+namespace
+{
+    constexpr size_t kProbes = 4096;
+}
+
+template<class OrderIndex>
+static void BM_SlidingWindow(benchmark::State& state)
+{
+    const Id window = state.range(0);
+    OrderIndex orders;
+    orders.Reserve(1000);
+    for (Id id = 0; id < window; ++id)
+    {
+        orders.Emplace(id, Order{ id, Side::Bid, 10.0, 5 });
+    }
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<Id> dist(1, window);
+    std::vector<Id> offsets(kProbes);
+    for (auto& offset : offsets)
+    {
+        offset = dist(rng);
+    }
+
+    Id next = window;
+    for (auto _ : state)
+    {
+        orders.Emplace(next, Order{ next, Side::Bid, 10.0, 5 });
+        benchmark::DoNotOptimize(orders.Find(next - offsets[next % kProbes] + 1));
+        orders.Erase(next - window);
+        next++;
+    }
+}
+BENCHMARK_TEMPLATE(BM_SlidingWindow, OrderMap)->Arg(1000)->Arg(10000)->Arg(100000)->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_SlidingWindow, OrderTable)->Arg(1000)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+template<class OrderIndex>
+static void BM_Find(benchmark::State& state)
+{
+    const Id window = state.range(0);
+    OrderIndex orders;
+    for (Id id = 0; id < window; ++id)
+    {
+        orders.Emplace(id, Order{ id, Side::Bid, 10.0, 5 });
+    }
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<Id> dist(0, window - 1);
+    std::vector<Id> ids(kProbes);
+    for (auto& id : ids)
+    {
+        id = dist(rng);
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(orders.Find(ids[i++ % kProbes]));
+    }
+}
+BENCHMARK_TEMPLATE(BM_Find, OrderMap)->Arg(1000)->Arg(100000)->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_Find, OrderTable)->Arg(1000)->Arg(100000)->Arg(1000000);
@@ -0,0 +1,74 @@
+#include "order_book.h"
+#include "risk.h"
+#include <benchmark/benchmark.h>
+#include <iostream>
+
+/**
+ * Cost of the inline pre-trade risk stage per order
+ * -> Arg(0) number of price levels per side of the book
+ * -> accepted orders run every check including the sweep
+ * -> rejected orders stop at the first failing check
+ */
+
+namespace
+{
+    constexpr AccountId kAccounts = 1024;
+
+    struct RiskFixture
+    {
+        RiskFixture(int64_t levels) :
+            mRiskChecker(kAccounts, 0.5 /*=priceBand*/)
+        {
+            std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+            for (int64_t i = 0; i < levels; ++i)
+            {
+                mOrderBook.AddOrder(Side::Bid, 100.0 - i * 0.01, 10);
+                mOrderBook.AddOrder(Side::Ask, 100.01 + i * 0.01, 10);
+            }
+            std::cout.rdbuf(coutBuffer);
+            for (AccountId account = 0; account < kAccounts; ++account)
+            {
+                mRiskChecker.SetLimits(account, RiskLimits{ 1000, 1e6, 100000, 1e9, 1000 });
+            }
+        }
+
+        OrderBook mOrderBook;
+        RiskChecker mRiskChecker;
+    };
+}
+
+static void BM_RiskAccepted(benchmark::State& state)
+{
+    RiskFixture fixture(state.range(0));
+    AccountId account = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fixture.mRiskChecker.Check(fixture.mOrderBook, account, Side::Bid, 100.05, 50));
+        account = (account + 1) % kAccounts;
+    }
+}
+BENCHMARK(BM_RiskAccepted)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_RiskRejectedBand(benchmark::State& state)
+{
+    RiskFixture fixture(state.range(0));
+    AccountId account = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fixture.mRiskChecker.Check(fixture.mOrderBook, account, Side::Bid, 500.0, 50));
+        account = (account + 1) % kAccounts;
+    }
+}
+BENCHMARK(BM_RiskRejectedBand)->Arg(1000);
+
+static void BM_RiskRejectedVolume(benchmark::State& state)
+{
+    RiskFixture fixture(state.range(0));
+    AccountId account = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fixture.mRiskChecker.Check(fixture.mOrderBook, account, Side::Bid, 100.05, 5000));
+        account = (account + 1) % kAccounts;
+    }
+}
+BENCHMARK(BM_RiskRejectedVolume)->Arg(1000);
@@ -0,0 +1,168 @@
+#include "arena.h"
+#include <algorithm>
+#include <iostream>
+#include <sys/mman.h>
+
+namespace
+{
+    constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+    constexpr size_t kPageSize = 4096;
+    // every block is aligned to min(block size, kMaxAlignment)
+    constexpr size_t kMaxAlignment = 64;
+
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    void Prefault(char* memory, size_t size)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(memory, size, MADV_POPULATE_WRITE) == 0)
+        {
+            return;
+        }
+#endif
+        // older kernels, touch every page instead
+        for (size_t offset = 0; offset < size; offset += kPageSize)
+        {
+            static_cast<volatile char*>(memory)[offset] = 0;
+        }
+    }
+}
+
+Arena::Arena(size_t capacity, bool hugePages, bool lock, std::pmr::memory_resource* upstream) :
+    mUpstream(upstream)
+{
+    mCapacity = AlignUp(capacity, kHugePageSize);
+    void* memory = MAP_FAILED;
+    if (hugePages)
+    {
+        memory = mmap(nullptr, mCapacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        mHugePages = memory != MAP_FAILED;
+    }
+    if (memory == MAP_FAILED)
+    {
+        // not populated yet, pages faulted in before the madvise would stay 4K pages
+        memory = mmap(nullptr, mCapacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+            if (hugePages)
+            {
+                // no reserved huge pages, ask for transparent huge pages instead
+                madvise(memory, mCapacity, MADV_HUGEPAGE);
+            }
+            Prefault(static_cast<char*>(memory), mCapacity);
+        }
+    }
+    if (memory == MAP_FAILED)
+    {
+        std::cout << "[ERROR] Failed to map arena with capacity=" << mCapacity << ", all allocations will go upstream" << std::endl;
+        mCapacity = 0;
+        return;
+    }
+    mBegin = static_cast<char*>(memory);
+
+    if (lock)
+    {
+        mLocked = mlock(mBegin, mCapacity) == 0;
+        if (!mLocked)
+        {
+            std::cout << "[WARN] Failed to mlock arena with capacity=" << mCapacity << std::endl;
+        }
+    }
+}
+
+Arena::~Arena()
+{
+    if (mBegin != nullptr)
+    {
+        if (mLocked)
+        {
+            munlock(mBegin, mCapacity);
+        }
+        munmap(mBegin, mCapacity);
+    }
+}
+
+size_t Arena::GetCapacity() const
+{
+    return mCapacity;
+}
+
+size_t Arena::GetUsed() const
+{
+    return mOffset;
+}
+
+size_t Arena::GetUpstreamAllocations() const
+{
+    return mUpstreamAllocations;
+}
+
+bool Arena::IsHugePages() const
+{
+    return mHugePages;
+}
+
+bool Arena::IsLocked() const
+{
+    return mLocked;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    size_t sizeClass = GetSizeClass(bytes, alignment);
+    if (sizeClass < kNumSizeClasses && alignment <= kMaxAlignment)
+    {
+        auto& freeList = mFreeLists[sizeClass];
+        if (freeList != nullptr)
+        {
+            FreeBlock* block = freeList;
+            freeList = block->mNext;
+            return block;
+        }
+
+        size_t blockSize = size_t{ 1 } << sizeClass;
+        size_t offset = AlignUp(mOffset, std::min(blockSize, kMaxAlignment));
+        if (offset + blockSize <= mCapacity)
+        {
+            mOffset = offset + blockSize;
+            return mBegin + offset;
+        }
+    }
+
+    mUpstreamAllocations++;
+    return mUpstream->allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    if (!Owns(p))
+    {
+        mUpstream->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    auto* block = static_cast<FreeBlock*>(p);
+    auto& freeList = mFreeLists[GetSizeClass(bytes, alignment)];
+    block->mNext = freeList;
+    freeList = block;
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+size_t Arena::GetSizeClass(size_t bytes, size_t alignment)
+{
+    size_t size = std::max({ bytes, alignment, size_t{ 1 } << kMinSizeClass });
+    return 64 - __builtin_clzll(size - 1);
+}
+
+bool Arena::Owns(const void* p) const
+{
+    auto* bytes = static_cast<const char*>(p);
+    return mBegin != nullptr && bytes >= mBegin && bytes < mBegin + mCapacity;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * Preallocated memory pool used by the order book containers
+ *
+ * Usage
+ * -> Arena arena(capacity, hugePages, lock)
+ * -> OrderBook orderBook(&arena, OrderBookCapacity{ maxOrders, maxLevels })
+ *
+ * Notes
+ * -> the whole capacity is mapped (and prefaulted) once at construction
+ * -> huge pages are requested with MAP_HUGETLB, falling back to transparent
+ *    huge pages (madvise before prefaulting) when no huge pages are reserved on the host
+ * -> optionally the pool is locked in RAM with mlock so it can never be paged out
+ * -> allocations are rounded up to power of two size classes
+ *    freed blocks go to a per class free list and are recycled by later allocations
+ *    (vectors growing/shrinking and levels coming and going reuse the same blocks)
+ * -> once the pool is exhausted allocations are served by the upstream resource
+ *    and counted, so tests can assert the hot path never reaches malloc
+ *
+ * Complexity
+ * -> ALLOCATE
+ *  --> O(1) pop from free list or bump of the offset
+ * -> DEALLOCATE
+ *  --> O(1) push on free list
+ */
+
+class Arena : public std::pmr::memory_resource
+{
+public:
+    explicit Arena(size_t capacity, bool hugePages = true, bool lock = false,
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    size_t GetCapacity() const;
+    size_t GetUsed() const;
+    size_t GetUpstreamAllocations() const;
+    bool IsHugePages() const;
+    bool IsLocked() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    static size_t GetSizeClass(size_t bytes, size_t alignment);
+    bool Owns(const void* p) const;
+
+    struct FreeBlock
+    {
+        FreeBlock* mNext;
+    };
+
+    static constexpr size_t kMinSizeClass = 4; // 16 bytes
+    static constexpr size_t kNumSizeClasses = 48;
+
+    char* mBegin = nullptr;
+    size_t mCapacity = 0;
+    size_t mOffset = 0;
+    size_t mUpstreamAllocations = 0;
+    bool mHugePages = false;
+    bool mLocked = false;
+    std::pmr::memory_resource* mUpstream;
+    std::array<FreeBlock*, kNumSizeClasses> mFreeLists{};
+};
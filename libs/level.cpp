@@ -1,9 +1,10 @@
 #include "level.h"
 #include <iostream>
 
-Level::Level()
+Level::Level(std::pmr::memory_resource* resource, size_t reserve) :
+    mOrders(resource)
 {
-    mOrders.reserve(1000);
+    mOrders.reserve(reserve);
 }
 
 void Level::PopFront()
@@ -11,6 +12,20 @@ void Level::PopFront()
     mStart++;
 }
 
+void Level::PopInactive()
+{
+    while (!Empty() && !Front().mIsActive)
+    {
+        PopFront();
+    }
+    if (Empty())
+    {
+        // drained, start over at the beginning of the storage
+        mOrders.clear();
+        mStart = 0;
+    }
+}
+
 bool Level::ModifyOrder(const Order& order, const Volume newVolume)
 {
     auto& levelOrder = mOrders[order.mLevelIndex];
@@ -64,4 +79,59 @@ size_t Level::GetStart() const
 size_t Level::GetEnd() const
 {
     return mOrders.size();
+}
+
+PriceLevels::PriceLevels(std::pmr::memory_resource* resource) :
+    mPrices(resource),
+    mVolumes(resource),
+    mLevels(resource)
+{}
+
+std::pmr::memory_resource* PriceLevels::GetResource() const
+{
+    return mLevels.get_allocator().resource();
+}
+
+Level PriceLevels::MakeLevel() const
+{
+    return Level(GetResource(), mOrdersPerLevel);
+}
+
+void PriceLevels::Reserve(size_t levels, size_t ordersPerLevel)
+{
+    mPrices.reserve(levels);
+    mVolumes.reserve(levels);
+    mLevels.reserve(levels);
+    mOrdersPerLevel = ordersPerLevel;
+}
+
+void PriceLevels::Insert(size_t index, Price price, Volume volume, Level&& level)
+{
+    mPrices.insert(mPrices.begin() + index, price);
+    mVolumes.insert(mVolumes.begin() + index, volume);
+    mLevels.insert(mLevels.begin() + index, std::move(level));
+}
+
+void PriceLevels::Erase(size_t index)
+{
+    mPrices.erase(mPrices.begin() + index);
+    mVolumes.erase(mVolumes.begin() + index);
+    mLevels.erase(mLevels.begin() + index);
+}
+
+void PriceLevels::PopBack()
+{
+    mPrices.pop_back();
+    mVolumes.pop_back();
+    mLevels.pop_back();
+}
+
+bool PriceLevels::Empty() const
+{
+    return mPrices.empty();
+}
+
+size_t PriceLevels::Size() const
+{
+    return mPrices.size();
 }
\ No newline at end of file
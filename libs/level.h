@@ -1,10 +1,20 @@
 #pragma once
+#include <memory_resource>
 #include "order.h"
 
+/**
+ * Orders resting on one price level in time priority
+ * -> deleted/filled orders are only flagged inactive and skipped
+ * -> once the storage is full and at least half of it is inactive, CompactIfFull
+ *    moves the active orders to the front instead of growing the storage,
+ *    so a long lived level under churn stays bounded by twice its live orders
+ */
 class Level
 {
 public:
-    Level();
+    static constexpr size_t kDefaultReserve = 8;
+
+    explicit Level(std::pmr::memory_resource* resource = std::pmr::get_default_resource(), size_t reserve = kDefaultReserve);
 
     template <typename... Args>
     void EmplaceBack(Args&&... args)
@@ -12,9 +22,60 @@ public:
         mOrders.emplace_back(std::forward<Args>(args)...);
     }
 
+    // calls function(order) for active orders in time priority until it returns false
+    template <typename Function>
+    void ForEach(Function&& function)
+    {
+        for (size_t i = mStart; i < mOrders.size(); ++i)
+        {
+            if (mOrders[i].mIsActive && !function(mOrders[i]))
+            {
+                break;
+            }
+        }
+    }
+
+    // calls onMove(order) for every order whose mLevelIndex changed
+    template <typename OnMove>
+    void CompactIfFull(OnMove&& onMove)
+    {
+        if (mOrders.size() < mOrders.capacity())
+        {
+            return;
+        }
+        size_t active = 0;
+        for (size_t i = mStart; i < mOrders.size(); ++i)
+        {
+            active += mOrders[i].mIsActive;
+        }
+        if (2 * active > mOrders.size())
+        {
+            return;
+        }
+
+        size_t end = 0;
+        for (size_t i = mStart; i < mOrders.size(); ++i)
+        {
+            if (!mOrders[i].mIsActive)
+            {
+                continue;
+            }
+            if (i != end)
+            {
+                mOrders[end] = mOrders[i];
+                mOrders[end].mLevelIndex = end;
+                onMove(mOrders[end]);
+            }
+            end++;
+        }
+        mOrders.resize(end);
+        mStart = 0;
+    }
+
     bool ModifyOrder(const Order&, const Volume);
     bool DeleteOrder(const Order&);
     void PopFront();
+    void PopInactive();
     Order& Front();
     bool Empty() const;
     size_t Size() const;
@@ -22,6 +83,33 @@ public:
     size_t GetEnd() const;
 
 private:
-    std::vector<Order> mOrders;
+    std::pmr::vector<Order> mOrders;
     size_t mStart = 0;
+};
+
+/**
+ * Price levels of one side of the book stored as structure of arrays
+ * -> mPrices keeps the contiguous price keys used by LowerBound/SweepVolume
+ * -> mVolumes keeps the aggregate resting volume of each level
+ * -> mLevels keeps the orders of each level
+ * -> all three vectors share the same index and ordering
+ * -> all three vectors (and the orders of new levels) draw from the same memory resource
+ * -> new levels reserve room for mOrdersPerLevel orders
+ */
+struct PriceLevels
+{
+    std::pmr::vector<Price> mPrices;
+    std::pmr::vector<Volume> mVolumes;
+    std::pmr::vector<Level> mLevels;
+    size_t mOrdersPerLevel = Level::kDefaultReserve;
+
+    explicit PriceLevels(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    std::pmr::memory_resource* GetResource() const;
+    Level MakeLevel() const;
+    void Reserve(size_t levels, size_t ordersPerLevel);
+    void Insert(size_t index, Price, Volume, Level&&);
+    void Erase(size_t index);
+    void PopBack();
+    bool Empty() const;
+    size_t Size() const;
 };
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "level_search.h"
+#include <iostream>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVEL_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // binary search stops once the candidate range fits in this many prices
+    constexpr size_t kSearchWindow = 16;
+
+    using CountFn = size_t (*)(const Price*, size_t, Price, Side);
+    using SumFn = Volume (*)(const Volume*, size_t);
+
+    size_t CountScalar(const Price* prices, size_t count, Price price, Side side)
+    {
+        size_t result = 0;
+        if (side == Side::Bid)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                result += BidComparator(prices[i], price);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                result += AskComparator(prices[i], price);
+            }
+        }
+        return result;
+    }
+
+    Volume SumScalar(const Volume* volumes, size_t count)
+    {
+        Volume result = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            result += volumes[i];
+        }
+        return result;
+    }
+
+#ifdef LEVEL_SEARCH_X86
+    __attribute__((target("avx2")))
+    size_t CountAvx2(const Price* prices, size_t count, Price price, Side side)
+    {
+        const __m256d key = _mm256_set1_pd(price);
+        size_t result = 0;
+        size_t i = 0;
+        if (side == Side::Bid)
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(prices + i), key, _CMP_LT_OQ);
+                result += __builtin_popcount(_mm256_movemask_pd(mask));
+            }
+        }
+        else
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(prices + i), key, _CMP_GT_OQ);
+                result += __builtin_popcount(_mm256_movemask_pd(mask));
+            }
+        }
+        return result + CountScalar(prices + i, count - i, price, side);
+    }
+
+    __attribute__((target("avx2")))
+    Volume SumAvx2(const Volume* volumes, size_t count)
+    {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(volumes + i)));
+            acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(volumes + i + 4)));
+        }
+        alignas(32) Volume lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumScalar(volumes + i, count - i);
+    }
+#endif
+
+    struct Dispatch
+    {
+        SimdLevel mLevel;
+        CountFn mCount;
+        SumFn mSum;
+    };
+
+    Dispatch MakeDispatch(SimdLevel level)
+    {
+        switch (level)
+        {
+#ifdef LEVEL_SEARCH_X86
+            case SimdLevel::Avx2:
+                return { SimdLevel::Avx2, CountAvx2, SumAvx2 };
+#endif
+            default:
+                return { SimdLevel::Scalar, CountScalar, SumScalar };
+        }
+    }
+
+    SimdLevel DetectSimdLevel()
+    {
+#ifdef LEVEL_SEARCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SimdLevel::Avx2;
+        }
+#endif
+        // 2 wide SSE2 compares measured slower than the scalar loop, hosts without AVX2 stay scalar
+        return SimdLevel::Scalar;
+    }
+
+    // function local static so books constructed during static init see a valid dispatch
+    Dispatch& GetDispatch()
+    {
+        static Dispatch dispatch = MakeDispatch(DetectSimdLevel());
+        return dispatch;
+    }
+}
+
+size_t LowerBound(const Price* prices, size_t count, Price price, Side side)
+{
+    const Price* base = prices;
+    size_t length = count;
+    if (side == Side::Bid)
+    {
+        while (length > kSearchWindow)
+        {
+            size_t half = length / 2;
+            base = BidComparator(base[half], price) ? base + half : base;
+            length -= half;
+        }
+    }
+    else
+    {
+        while (length > kSearchWindow)
+        {
+            size_t half = length / 2;
+            base = AskComparator(base[half], price) ? base + half : base;
+            length -= half;
+        }
+    }
+    return static_cast<size_t>(base - prices) + GetDispatch().mCount(base, length, price, side);
+}
+
+Volume SweepVolume(const Price* prices, const Volume* volumes, size_t count, Price price, Side side)
+{
+    size_t first = LowerBound(prices, count, price, side);
+    return GetDispatch().mSum(volumes + first, count - first);
+}
+
+SimdLevel GetSimdLevel()
+{
+    return GetDispatch().mLevel;
+}
+
+SimdLevel GetSupportedSimdLevel()
+{
+    return DetectSimdLevel();
+}
+
+bool SetSimdLevel(SimdLevel level)
+{
+    if (static_cast<int>(level) > static_cast<int>(DetectSimdLevel()))
+    {
+        std::cout << "[WARN] SIMD level=" << level << " is not supported on this CPU" << std::endl;
+        return false;
+    }
+    GetDispatch() = MakeDispatch(level);
+    return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const SimdLevel& level)
+{
+    switch (level)
+    {
+        case SimdLevel::Scalar:
+            os << "SCALAR";
+            break;
+        case SimdLevel::Avx2:
+            os << "AVX2";
+            break;
+    }
+    return os;
+}
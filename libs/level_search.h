@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include "order.h"
+
+/**
+ * Search and sweep primitives over the contiguous price key arrays of the book
+ *
+ * Layout
+ * -> bid prices are sorted in ascending order
+ * -> ask prices are sorted in descending order
+ * -> the TOP of the book is the last element for both sides
+ *
+ * Operations
+ * -> LowerBound(prices, count, price, side)
+ *  --> same result as std::lower_bound with BidComparator/AskComparator
+ * -> SweepVolume(prices, volumes, count, price, side)
+ *  --> total volume resting on levels that an aggressive order with limit price
+ *      would be able to match against (levels from the lower bound up to the TOP)
+ *
+ * Notes
+ * -> branchless binary search narrows the range down to a small window
+ *    and the window is then resolved with a vectorized compare and count
+ * -> the sweep sums the volume tail with vectorized 64 bit adds
+ * -> implementation is picked once at startup based on the CPU (AVX2 or scalar)
+ *    and can be overridden with SetSimdLevel (used by tests and benchmarks)
+ */
+
+enum class SimdLevel { Scalar, Avx2 };
+
+size_t LowerBound(const Price* prices, size_t count, Price price, Side side);
+Volume SweepVolume(const Price* prices, const Volume* volumes, size_t count, Price price, Side side);
+
+SimdLevel GetSimdLevel();
+SimdLevel GetSupportedSimdLevel();
+bool SetSimdLevel(SimdLevel);
+
+std::ostream& operator<<(std::ostream& os, const SimdLevel& level);
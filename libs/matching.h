@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include "level.h"
+
+/**
+ * Matching policies used as template parameter of BasicOrderBook
+ *
+ * Allocate(level, levelVolume, volume, fill)
+ * -> allocates the volume of an aggressive order over the active orders of
+ *    the resting level (levelVolume is the aggregate volume of the level)
+ * -> calls fill(restingOrder, matchVolume) once per allocation, in time priority
+ * -> allocates min(volume, levelVolume) in total
+ *
+ * FifoMatching
+ * -> price-time priority, oldest resting order is filled first
+ *
+ * ProRataMatching
+ * -> every resting order gets a share proportional to its volume
+ * -> one pass with cumulative rounding: the orders up to and including the
+ *    i-th get ceil(volume * cumulativeVolume_i / levelVolume) in total, so the
+ *    total is exact, no order gets more than its volume and the lots lost to
+ *    rounding go to the older orders (time priority breaks ties)
+ * -> aggressive orders larger than the level fill the whole level (same as FIFO)
+ *
+ * TopOrderProRataMatching
+ * -> oldest resting order of the level is filled first (top order priority),
+ *    the remaining volume is allocated pro-rata over the rest of the level
+ */
+
+struct FifoMatching
+{
+    template<class Fill>
+    static void Allocate(Level& level, const Volume, Volume volume, Fill&& fill)
+    {
+        level.ForEach([&](Order& order)
+        {
+            Volume matchVolume = std::min(volume, order.mVolume);
+            fill(order, matchVolume);
+            volume -= matchVolume;
+            return volume > 0;
+        });
+    }
+};
+
+struct ProRataMatching
+{
+    template<class Fill>
+    static void Allocate(Level& level, const Volume levelVolume, const Volume volume, Fill&& fill)
+    {
+        if (volume >= levelVolume)
+        {
+            FifoMatching::Allocate(level, levelVolume, volume, fill);
+            return;
+        }
+        AllocateProRata(level, levelVolume, volume, fill);
+    }
+
+    // requires volume < levelVolume, levelVolume being the sum of the order volumes
+    template<class Fill>
+    static void AllocateProRata(Level& level, const Volume levelVolume, const Volume volume, Fill&& fill)
+    {
+        unsigned __int128 cumulative = 0;
+        Volume allocated = 0;
+        level.ForEach([&](Order& order)
+        {
+            cumulative += order.mVolume;
+            Volume target = static_cast<Volume>((volume * cumulative + levelVolume - 1) / levelVolume);
+            if (target > allocated)
+            {
+                fill(order, target - allocated);
+                allocated = target;
+            }
+            return allocated < volume;
+        });
+    }
+};
+
+struct TopOrderProRataMatching
+{
+    template<class Fill>
+    static void Allocate(Level& level, const Volume levelVolume, Volume volume, Fill&& fill)
+    {
+        if (volume >= levelVolume)
+        {
+            FifoMatching::Allocate(level, levelVolume, volume, fill);
+            return;
+        }
+
+        Volume topVolume = 0;
+        level.ForEach([&](Order& order)
+        {
+            topVolume = order.mVolume;
+            Volume matchVolume = std::min(volume, topVolume);
+            fill(order, matchVolume);
+            volume -= matchVolume;
+            return false;
+        });
+        if (volume > 0)
+        {
+            // the top order is fully filled here (inactive, skipped by ForEach)
+            // and volume < levelVolume - topVolume
+            ProRataMatching::AllocateProRata(level, levelVolume - topVolume, volume, fill);
+        }
+    }
+};
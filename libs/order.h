@@ -34,7 +34,9 @@ struct Order
     bool operator!=(const Order& other) const;
 };
 
-using OnTradeCallback = std::function<void(const Order&, const Order&, Volume)>;
+// bidOrder, askOrder (before the fill), volume, price (of the resting order), aggressorSide
+using OnTradeCallback = std::function<void(const Order&, const Order&, Volume, Price, Side)>;
+using OnBookUpdateCallback = std::function<void(Side, Price, Volume)>;
 
 std::ostream& operator<<(std::ostream& os, const Side& side);
 std::ostream& operator<<(std::ostream& os, const Order& order);
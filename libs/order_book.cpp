@@ -2,104 +2,145 @@
 #include <sstream>
 #include <iostream>
 
-OrderBook::OrderBook()
+template<class OrderIndex, class Matching>
+BasicOrderBook<OrderIndex, Matching>::BasicOrderBook(std::pmr::memory_resource* resource, const OrderBookCapacity& capacity) :
+    mOrders(resource),
+    mBidLevels(resource),
+    mAskLevels(resource)
 {
-    mOrders.reserve(1000);
-    mBidLevels.reserve(1000);
-    mAskLevels.reserve(1000);
+    mOrders.Reserve(capacity.mOrders);
+    mBidLevels.Reserve(capacity.mLevels, capacity.mOrdersPerLevel);
+    mAskLevels.Reserve(capacity.mLevels, capacity.mOrdersPerLevel);
     mOnTradeCallback = nullptr;
+    mOnBookUpdateCallback = nullptr;
 }
 
-std::optional<Id> OrderBook::AddOrder(const Side side, const Price price, const Volume volume)
+template<class OrderIndex, class Matching>
+std::optional<Id> BasicOrderBook<OrderIndex, Matching>::AddOrder(const Side side, const Price price, const Volume volume)
 {
     Id newId = mId++;
     auto& sideLevels = side == Side::Bid ? mBidLevels : mAskLevels;
-    auto compare = side == Side::Bid ? BidComparator : AskComparator;
-    
-    auto [orderIt, inserted] = mOrders.emplace(newId, Order{ newId, side, price, volume });
+
+    auto [order, inserted] = mOrders.Emplace(newId, Order{ newId, side, price, volume });
     if (!inserted)
     {
         std::cout << "[WARN] Failed to emplace in mOrders while calling AddOrder with id=" << newId << std::endl;
         return std::nullopt;
     }
-    orderIt->second.mLevelIndex = AddOrder(sideLevels, newId, side, price, volume, compare);
-    std::cout << "[UPDATE] Added order=" << orderIt->second << std::endl;
+    order->mLevelIndex = AddOrder(sideLevels, newId, side, price, volume);
+    std::cout << "[UPDATE] Added order=" << *order << std::endl;
 
-    MatchOrders();
+    MatchOrders(side);
+    // matching only published the resting side, the new order's level goes out once it rests
+    if (mOnBookUpdateCallback && mOrders.Find(newId) != nullptr)
+    {
+        NotifyLevel(side, price);
+    }
     return newId;
 }
 
-bool OrderBook::ModifyOrder(const Id orderId, const Price newPrice, const Volume newVolume)
+template<class OrderIndex, class Matching>
+bool BasicOrderBook<OrderIndex, Matching>::ModifyOrder(const Id orderId, const Price newPrice, const Volume newVolume)
 {
-    auto it = mOrders.find(orderId);
-    if (it == mOrders.end() || !it->second.mIsActive)
+    auto* order = mOrders.Find(orderId);
+    if (order == nullptr || !order->mIsActive)
     {
         std::cout << "[WARN] Could not find existing order while calling ModifyOrder with id=" << orderId << std::endl;
         return false;
     }
 
-    Side side = it->second.mSide;
+    Side side = order->mSide;
     DeleteOrder(orderId);
     AddOrder(side, newPrice, newVolume);
     return true;
 }
 
-bool OrderBook::DeleteOrder(const Id orderId)
+template<class OrderIndex, class Matching>
+bool BasicOrderBook<OrderIndex, Matching>::DeleteOrder(const Id orderId)
 {
-    auto it = mOrders.find(orderId);
-    if (it == mOrders.end() || !it->second.mIsActive)
+    auto* found = mOrders.Find(orderId);
+    if (found == nullptr || !found->mIsActive)
     {
         std::cout << "[WARN] Could not find existing order while calling DeleteOrder with id=" << orderId << std::endl;
         return false;
     }
 
-    auto& order = it->second;
+    auto& order = *found;
     auto& sideLevels = order.mSide == Side::Bid ? mBidLevels : mAskLevels;
-    auto compare = order.mSide == Side::Bid ? BidComparator : AskComparator;
-    bool deleted = DeleteOrder(sideLevels, order, compare);
+    bool deleted = DeleteOrder(sideLevels, order);
     order.mIsActive = false;
-    mOrders.erase(it);
 
+    // log before the erase, order refers to the slot in mOrders
     std::cout << "[" << (deleted ? "UPDATE]" : "ERROR]") << " Deleted order=" << order << std::endl;
+    mOrders.Erase(orderId);
     return true;
 }
 
-const Order* OrderBook::FindOrder(const Id orderId)
+template<class OrderIndex, class Matching>
+const Order* BasicOrderBook<OrderIndex, Matching>::FindOrder(const Id orderId)
 {
-    auto it = mOrders.find(orderId);
-    if (it == mOrders.end())
+    auto* order = mOrders.Find(orderId);
+    if (order == nullptr)
     {
         std::cout << "[WARN] Could not find existing order while calling GetOrder with id=" << orderId << std::endl;
         return nullptr;
     }
-    return &it->second;
+    return order;
 }
 
-void OrderBook::SetOnTradeCallback(OnTradeCallback callback)
+template<class OrderIndex, class Matching>
+void BasicOrderBook<OrderIndex, Matching>::SetOnTradeCallback(OnTradeCallback callback)
 {
     mOnTradeCallback = std::move(callback);
 }
 
-std::optional<Price> OrderBook::GetBestBid() const
+template<class OrderIndex, class Matching>
+void BasicOrderBook<OrderIndex, Matching>::SetOnBookUpdateCallback(OnBookUpdateCallback callback)
+{
+    mOnBookUpdateCallback = std::move(callback);
+}
+
+template<class OrderIndex, class Matching>
+Id BasicOrderBook<OrderIndex, Matching>::GetNextId() const
 {
-    if (mBidLevels.empty())
+    return mId;
+}
+
+template<class OrderIndex, class Matching>
+std::optional<Price> BasicOrderBook<OrderIndex, Matching>::GetBestBid() const
+{
+    if (mBidLevels.Empty())
     {
         return std::nullopt;
     }
-    return mBidLevels.back().first;
+    return mBidLevels.mPrices.back();
 }
 
-std::optional<Price> OrderBook::GetBestAsk() const
+template<class OrderIndex, class Matching>
+std::optional<Price> BasicOrderBook<OrderIndex, Matching>::GetBestAsk() const
 {
-    if (mAskLevels.empty())
+    if (mAskLevels.Empty())
     {
         return std::nullopt;
     }
-    return mAskLevels.back().first;
+    return mAskLevels.mPrices.back();
+}
+
+template<class OrderIndex, class Matching>
+Volume BasicOrderBook<OrderIndex, Matching>::GetSweepVolume(const Side side, const Price price) const
+{
+    // an aggressive order sweeps the levels of the opposite side
+    const auto& sideLevels = side == Side::Bid ? mAskLevels : mBidLevels;
+    const Side levelSide = side == Side::Bid ? Side::Ask : Side::Bid;
+    return SweepVolume(sideLevels.mPrices.data(), sideLevels.mVolumes.data(), sideLevels.Size(), price, levelSide);
 }
 
-void OrderBook::MatchOrders()
+template<class OrderIndex, class Matching>
+void BasicOrderBook<OrderIndex, Matching>::MatchOrders(const Side side)
 {
+    auto& aggressiveLevels = side == Side::Bid ? mBidLevels : mAskLevels;
+    auto& restingLevels = side == Side::Bid ? mAskLevels : mBidLevels;
+
     while (true)
     {
         auto bestBid = GetBestBid();
@@ -110,61 +151,93 @@ void OrderBook::MatchOrders()
             break;
         }
 
-        auto& bidLevel = mBidLevels.back().second;
-        auto& askLevel = mAskLevels.back().second;
+        auto& aggressiveLevel = aggressiveLevels.mLevels.back();
+        auto& restingLevel = restingLevels.mLevels.back();
 
-        // cleanup inactive bids
-        while (!bidLevel.Empty() && !bidLevel.Front().mIsActive)
-        {
-            bidLevel.PopFront();
-        }
+        // cleanup inactive orders
+        aggressiveLevel.PopInactive();
+        restingLevel.PopInactive();
 
-        // cleanup inactive asks
-        while (!askLevel.Empty() && !askLevel.Front().mIsActive)
+        if (aggressiveLevel.Empty() || restingLevel.Empty())
         {
-            askLevel.PopFront();
-        }
-
-        if (bidLevel.Empty() || askLevel.Empty())
-        {
-            bidLevel.Empty() ? mBidLevels.pop_back() : mAskLevels.pop_back();
+            aggressiveLevel.Empty() ? aggressiveLevels.PopBack() : restingLevels.PopBack();
             continue;
         }
 
-        auto& bidOrder = bidLevel.Front();
-        auto& askOrder = askLevel.Front();
-
-        uint64_t matchVolume = std::min(bidOrder.mVolume, askOrder.mVolume);
-        std::cout << "[TRADE] volume=" << matchVolume << " bid order=" << bidOrder << " ask order=" << askOrder << std::endl;
-        if (mOnTradeCallback)
+        // the book was not crossed before the new order, so it is alone at the TOP of its side
+        auto& aggressiveOrder = aggressiveLevel.Front();
+        Matching::Allocate(restingLevel, restingLevels.mVolumes.back(), aggressiveOrder.mVolume, [&](Order& restingOrder, Volume matchVolume)
         {
-            mOnTradeCallback(bidOrder, askOrder, matchVolume);
-        }
-
-        bidOrder.mVolume -= matchVolume;
-        askOrder.mVolume -= matchVolume;
-
-        if (bidOrder.mVolume == 0)
+            auto& bidOrder = side == Side::Bid ? aggressiveOrder : restingOrder;
+            auto& askOrder = side == Side::Bid ? restingOrder : aggressiveOrder;
+            std::cout << "[TRADE] volume=" << matchVolume << " bid order=" << bidOrder << " ask order=" << askOrder << std::endl;
+            if (mOnTradeCallback)
+            {
+                mOnTradeCallback(bidOrder, askOrder, matchVolume, restingOrder.mPrice, side);
+            }
+
+            FillOrder(aggressiveOrder, matchVolume);
+            FillOrder(restingOrder, matchVolume);
+            aggressiveLevels.mVolumes.back() -= matchVolume;
+            restingLevels.mVolumes.back() -= matchVolume;
+        });
+
+        aggressiveLevel.PopInactive();
+        restingLevel.PopInactive();
+        NotifyBookUpdate(side == Side::Bid ? Side::Ask : Side::Bid, restingLevels.mPrices.back(), restingLevel.Empty() ? 0 : restingLevels.mVolumes.back());
+
+        if (aggressiveLevel.Empty())
         {
-            mOrders.erase(bidOrder.mId);
-            bidLevel.PopFront();
+            aggressiveLevels.PopBack();
         }
 
-        if (askOrder.mVolume == 0)
+        if (restingLevel.Empty())
         {
-            mOrders.erase(askOrder.mId);
-            askLevel.PopFront();
+            restingLevels.PopBack();
         }
+    }
+    return;
+}
 
-        if (bidLevel.Empty())
-        {
-            mBidLevels.pop_back();
-        }
+template<class OrderIndex, class Matching>
+void BasicOrderBook<OrderIndex, Matching>::FillOrder(Order& order, const Volume volume)
+{
+    order.mVolume -= volume;
+    if (order.mVolume == 0)
+    {
+        order.mIsActive = false;
+        mOrders.Erase(order.mId);
+    }
+    // keep the indexed copy in sync so partially filled orders can still be found/deleted
+    else if (auto* indexed = mOrders.Find(order.mId))
+    {
+        indexed->mVolume = order.mVolume;
+    }
+}
 
-        if (askLevel.Empty())
-        {
-            mAskLevels.pop_back();
-        }
+template<class OrderIndex, class Matching>
+void BasicOrderBook<OrderIndex, Matching>::NotifyBookUpdate(const Side side, const Price price, const Volume volume)
+{
+    if (mOnBookUpdateCallback)
+    {
+        mOnBookUpdateCallback(side, price, volume);
     }
-    return;
 }
+
+template<class OrderIndex, class Matching>
+void BasicOrderBook<OrderIndex, Matching>::NotifyLevel(const Side side, const Price price)
+{
+    const auto& sideLevels = side == Side::Bid ? mBidLevels : mAskLevels;
+    size_t index = LowerBound(sideLevels.mPrices.data(), sideLevels.Size(), price, side);
+    if (index != sideLevels.Size() && sideLevels.mPrices[index] == price)
+    {
+        NotifyBookUpdate(side, price, sideLevels.mVolumes[index]);
+    }
+}
+
+template class BasicOrderBook<OrderMap, FifoMatching>;
+template class BasicOrderBook<OrderMap, ProRataMatching>;
+template class BasicOrderBook<OrderMap, TopOrderProRataMatching>;
+template class BasicOrderBook<OrderTable, FifoMatching>;
+template class BasicOrderBook<OrderTable, ProRataMatching>;
+template class BasicOrderBook<OrderTable, TopOrderProRataMatching>;
@@ -2,9 +2,12 @@
 #include <string>
 #include <vector>
 #include <optional>
-#include <absl/container/flat_hash_map.h>
+#include <memory_resource>
 #include "order.h"
 #include "level.h"
+#include "level_search.h"
+#include "matching.h"
+#include "order_index.h"
 
 /**
  * Operations supported by the order book
@@ -14,15 +17,42 @@
  *  --> ModifyOrder(id, price, volume)
  * -> DELETE
  *  --> DeleteOrder(id)
+ * -> SWEEP
+ *  --> GetSweepVolume(side, price) volume available to an aggressive order
+ *
+ * Events
+ * -> OnTradeCallback(bidOrder, askOrder, volume, price, aggressorSide) for every match
+ *    trades happen at the price of the resting order
+ * -> OnBookUpdateCallback(side, price, volume) whenever the volume of a level
+ *    changes (volume 0 once the level is gone)
+ *    the level of a new order is only published after matching, and only if
+ *    the order rests, so the published book is never crossed
+ *    see shm_ring.h to publish both to other processes
  * 
  * Data structures used for the order book
- * -> one vector to keep track of price levels for bid side
- * -> one vector to keep track of price levels for ask side
- * -> one flat_hash_map to keep track of order ids to orders
+ * -> one PriceLevels to keep track of price levels for bid side
+ * -> one PriceLevels to keep track of price levels for ask side
+ *    (contiguous price keys, aggregate volumes and levels in separate vectors)
+ * -> one OrderIndex to keep track of order ids to orders
  *    needed for order modify/delete
+ *    OrderMap (flat_hash_map, default) or OrderTable (paged direct address table)
+ *    see order_index.h
+ * -> all containers draw from the memory resource given at construction
+ *    pass an Arena (see arena.h) to avoid calling malloc after startup
+ * -> the order index and both level vectors are reserved to the OrderBookCapacity
+ *    given at construction, they never rehash/reallocate while the book stays within it
+ * -> a level starts with room for mOrdersPerLevel orders and is compacted in place
+ *    before it grows, see Level
+ *
+ * Matching
+ * -> the Matching policy allocates an aggressive order over the resting level
+ *    FifoMatching (default), ProRataMatching or TopOrderProRataMatching
+ *    see matching.h
  * 
  * Notes
  * -> we use vectors to optimize for cache locality
+ * -> price keys are searched without touching the (much larger) levels
+ *    see level_search.h for the vectorized search and sweep
  * -> bid side vector is sorted in ascending order
  * -> ask side vector is sorted in descending order
  * -> most order book operations will happen around the TOP of the book
@@ -37,58 +67,87 @@
  *  --> log(N) to delete and add new order
  * -> DELETE
  *  --> log(N) to find the price level (binary search)
+ * -> SWEEP
+ *  --> log(N) + K to sum the volume of the K levels an aggressive order can reach
  */
 
-class OrderBook
+struct OrderBookCapacity
+{
+    size_t mOrders = 1000;  // live orders
+    size_t mLevels = 1000;  // price levels per side
+    size_t mOrdersPerLevel = Level::kDefaultReserve; // initial order storage of a new level
+};
+
+template<class OrderIndex, class Matching = FifoMatching>
+class BasicOrderBook
 {
 public:
-    OrderBook();
+    explicit BasicOrderBook(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        const OrderBookCapacity& capacity = OrderBookCapacity());
     std::optional<Id> AddOrder(const Side, const Price, const Volume);
     bool ModifyOrder(const Id orderId, const Price, const Volume);
     bool DeleteOrder(const Id orderId);
     const Order* FindOrder(const Id);
     void SetOnTradeCallback(OnTradeCallback);
+    void SetOnBookUpdateCallback(OnBookUpdateCallback);
 
+    Id GetNextId() const;
     std::optional<double> GetBestBid() const;
     std::optional<double> GetBestAsk() const;
+    Volume GetSweepVolume(const Side, const Price) const;
 
 private:
-    void MatchOrders();
+    void MatchOrders(const Side);
+    void FillOrder(Order&, const Volume);
+    void NotifyBookUpdate(const Side, const Price, const Volume);
+    void NotifyLevel(const Side, const Price);
 
-    template<class T, class Compare>
-    size_t AddOrder(T& levels, const Id id, const Side side, const Price price, const Volume volume, Compare compare)
+    template<class T>
+    size_t AddOrder(T& levels, const Id id, const Side side, const Price price, const Volume volume)
     {
-        auto it = std::lower_bound(levels.begin(), levels.end(), price, [compare](const auto& level, Price price)
-        {
-            return compare(level.first, price);
-        });
+        size_t index = LowerBound(levels.mPrices.data(), levels.Size(), price, side);
         size_t levelIndex = 0;
-        if (it != levels.end() && it->first == price)
+        if (index != levels.Size() && levels.mPrices[index] == price)
         {
-            auto& level = it->second;
+            auto& level = levels.mLevels[index];
+            level.CompactIfFull([&](const Order& moved)
+            {
+                if (auto* indexed = mOrders.Find(moved.mId))
+                {
+                    indexed->mLevelIndex = moved.mLevelIndex;
+                }
+            });
             levelIndex = level.GetEnd();
             level.EmplaceBack(Order{ id, side, price, volume, levelIndex });
+            levels.mVolumes[index] += volume;
         }
         else
         {
-            Level newLevel;
+            Level newLevel = levels.MakeLevel();
             newLevel.EmplaceBack(Order{ id, side, price, volume });
-            levels.insert(it, { price, std::move(newLevel) });
+            levels.Insert(index, price, volume, std::move(newLevel));
         }
         return levelIndex;
     }
 
-    template<class T, class Compare>
-    bool DeleteOrder(T& levels, const Order& order, Compare compare)
+    template<class T>
+    bool DeleteOrder(T& levels, const Order& order)
     {
-        auto it = std::lower_bound(levels.begin(), levels.end(), order.mPrice, [compare](const auto& level, Price price)
+        size_t index = LowerBound(levels.mPrices.data(), levels.Size(), order.mPrice, order.mSide);
+        if (index != levels.Size() && levels.mPrices[index] == order.mPrice)
         {
-            return compare(level.first, price);
-        });
-        if (it != levels.end() && it->first == order.mPrice)
-        {
-            auto& level = it->second;
-            level.DeleteOrder(order);
+            auto& level = levels.mLevels[index];
+            if (level.DeleteOrder(order))
+            {
+                levels.mVolumes[index] -= order.mVolume;
+            }
+            // drop the level once its last active order is gone so it no longer shows as best price
+            level.PopInactive();
+            NotifyBookUpdate(order.mSide, order.mPrice, level.Empty() ? 0 : levels.mVolumes[index]);
+            if (level.Empty())
+            {
+                levels.Erase(index);
+            }
         }
         else
         {
@@ -100,7 +159,20 @@ private:
 
     Id mId = 0;
     OnTradeCallback mOnTradeCallback;
-    absl::flat_hash_map<Id, Order> mOrders;
-    std::vector<std::pair<Price, Level>> mBidLevels;
-    std::vector<std::pair<Price, Level>> mAskLevels;
+    OnBookUpdateCallback mOnBookUpdateCallback;
+    OrderIndex mOrders;
+    PriceLevels mBidLevels;
+    PriceLevels mAskLevels;
 };
+
+using OrderBook = BasicOrderBook<OrderMap>;
+using DenseOrderBook = BasicOrderBook<OrderTable>;
+using ProRataOrderBook = BasicOrderBook<OrderMap, ProRataMatching>;
+using TopOrderProRataOrderBook = BasicOrderBook<OrderMap, TopOrderProRataMatching>;
+
+extern template class BasicOrderBook<OrderMap, FifoMatching>;
+extern template class BasicOrderBook<OrderMap, ProRataMatching>;
+extern template class BasicOrderBook<OrderMap, TopOrderProRataMatching>;
+extern template class BasicOrderBook<OrderTable, FifoMatching>;
+extern template class BasicOrderBook<OrderTable, ProRataMatching>;
+extern template class BasicOrderBook<OrderTable, TopOrderProRataMatching>;
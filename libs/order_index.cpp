@@ -0,0 +1,190 @@
+#include "order_index.h"
+#include <new>
+
+OrderMap::OrderMap(std::pmr::memory_resource* resource) :
+    mOrders(resource)
+{}
+
+void OrderMap::Reserve(size_t size)
+{
+    mOrders.reserve(size);
+}
+
+std::pair<Order*, bool> OrderMap::Emplace(const Id id, const Order& order)
+{
+    auto [it, inserted] = mOrders.emplace(id, order);
+    return { &it->second, inserted };
+}
+
+void OrderMap::Erase(const Id id)
+{
+    mOrders.erase(id);
+}
+
+size_t OrderMap::Size() const
+{
+    return mOrders.size();
+}
+
+OrderTable::OrderTable(std::pmr::memory_resource* resource) :
+    mResource(resource),
+    mPages(resource),
+    mFreePages(resource)
+{
+    GrowDirectory(16);
+}
+
+OrderTable::~OrderTable()
+{
+    for (Id page = mFirstPage; page < mEndPage; ++page)
+    {
+        if (Page* p = mPages[page & mPageMask])
+        {
+            mFreePages.push_back(p);
+        }
+    }
+    for (Page* p : mFreePages)
+    {
+        p->~Page();
+        mResource->deallocate(p, sizeof(Page), alignof(Page));
+    }
+}
+
+void OrderTable::Reserve(size_t size)
+{
+    size_t pages = size / kPageSize + 1;
+    GrowDirectory(pages + 1);
+    mFreePages.reserve(pages + 1);
+    while (mPageCount < pages)
+    {
+        mPageCount++;
+        mFreePages.push_back(new (mResource->allocate(sizeof(Page), alignof(Page))) Page());
+    }
+}
+
+std::pair<Order*, bool> OrderTable::Emplace(const Id id, const Order& order)
+{
+    Id page = id >> kPageShift;
+    if (page >= mEndPage)
+    {
+        if (mFirstPage == mEndPage)
+        {
+            // ring is empty, skip straight to the new page
+            mFirstPage = page;
+        }
+        GrowDirectory(page + 1 - mFirstPage);
+        for (Id gap = mEndPage; gap < page; ++gap)
+        {
+            mPages[gap & mPageMask] = nullptr;
+        }
+        mPages[page & mPageMask] = AcquirePage();
+
+        // the previous newest page will not receive ids anymore
+        Id sealed = mEndPage - 1;
+        mEndPage = page + 1;
+        if (sealed >= mFirstPage && sealed < page)
+        {
+            Page* p = mPages[sealed & mPageMask];
+            if (p != nullptr && p->mLiveCount == 0)
+            {
+                RetirePage(sealed);
+            }
+        }
+    }
+
+    Page* p = page >= mFirstPage ? mPages[page & mPageMask] : nullptr;
+    if (p == nullptr)
+    {
+        // id belongs to a page which was already retired
+        return { nullptr, false };
+    }
+
+    size_t slot = id & (kPageSize - 1);
+    if (p->mLive[slot])
+    {
+        return { &p->mOrders[slot], false };
+    }
+    p->mOrders[slot] = order;
+    p->mLive.set(slot);
+    p->mLiveCount++;
+    mSize++;
+    return { &p->mOrders[slot], true };
+}
+
+void OrderTable::Erase(const Id id)
+{
+    Id page = id >> kPageShift;
+    if (page - mFirstPage >= mEndPage - mFirstPage)
+    {
+        return;
+    }
+    Page* p = mPages[page & mPageMask];
+    size_t slot = id & (kPageSize - 1);
+    if (p == nullptr || !p->mLive[slot])
+    {
+        return;
+    }
+
+    p->mLive.reset(slot);
+    p->mLiveCount--;
+    mSize--;
+    if (p->mLiveCount == 0 && page + 1 != mEndPage)
+    {
+        RetirePage(page);
+    }
+}
+
+size_t OrderTable::Size() const
+{
+    return mSize;
+}
+
+size_t OrderTable::GetPageCount() const
+{
+    return mPageCount;
+}
+
+OrderTable::Page* OrderTable::AcquirePage()
+{
+    if (!mFreePages.empty())
+    {
+        Page* p = mFreePages.back();
+        mFreePages.pop_back();
+        return p;
+    }
+    mPageCount++;
+    return new (mResource->allocate(sizeof(Page), alignof(Page))) Page();
+}
+
+void OrderTable::RetirePage(Id page)
+{
+    auto& p = mPages[page & mPageMask];
+    mFreePages.push_back(p);
+    p = nullptr;
+    while (mFirstPage < mEndPage && mPages[mFirstPage & mPageMask] == nullptr)
+    {
+        mFirstPage++;
+    }
+}
+
+void OrderTable::GrowDirectory(size_t size)
+{
+    if (size <= mPages.size())
+    {
+        return;
+    }
+    size_t capacity = mPages.empty() ? 1 : mPages.size();
+    while (capacity < size)
+    {
+        capacity *= 2;
+    }
+
+    std::pmr::vector<Page*> pages(capacity, nullptr, mResource);
+    Id pageMask = capacity - 1;
+    for (Id page = mFirstPage; page < mEndPage; ++page)
+    {
+        pages[page & pageMask] = mPages[page & mPageMask];
+    }
+    mPages.swap(pages);
+    mPageMask = pageMask;
+}
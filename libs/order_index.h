@@ -0,0 +1,100 @@
+#pragma once
+#include <bitset>
+#include <memory_resource>
+#include <utility>
+#include <absl/container/flat_hash_map.h>
+#include "order.h"
+
+/**
+ * Order indexes used by the order book to go from order id to order
+ * -> Emplace(id, order)
+ * -> Find(id)
+ * -> Erase(id)
+ *
+ * OrderMap
+ * -> flat_hash_map keyed by id, works for any id sequence
+ *
+ * OrderTable
+ * -> paged direct address table, exploits that ids are dense and increasing
+ *    (the order book hands them out with mId++)
+ * -> a page holds the orders of kPageSize consecutive ids
+ * -> a ring of page pointers maps the page number (id >> kPageShift) to its page
+ * -> once every id of a page was handed out and all of its orders are gone
+ *    the page is retired and recycled for a later page
+ * -> memory is bounded by the window between the oldest live id and the newest id
+ *
+ * Complexity
+ * -> OrderMap: O(1) average, hash + probe
+ * -> OrderTable: O(1), shift + array load (no hashing, no probing)
+ */
+
+class OrderMap
+{
+public:
+    explicit OrderMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    void Reserve(size_t);
+    std::pair<Order*, bool> Emplace(const Id, const Order&);
+    void Erase(const Id);
+    size_t Size() const;
+
+    Order* Find(const Id id)
+    {
+        auto it = mOrders.find(id);
+        return it == mOrders.end() ? nullptr : &it->second;
+    }
+
+private:
+    absl::flat_hash_map<Id, Order, absl::Hash<Id>, std::equal_to<Id>, std::pmr::polymorphic_allocator<std::pair<const Id, Order>>> mOrders;
+};
+
+class OrderTable
+{
+public:
+    static constexpr size_t kPageShift = 12;
+    static constexpr size_t kPageSize = size_t{ 1 } << kPageShift;
+
+    explicit OrderTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    ~OrderTable();
+
+    OrderTable(const OrderTable&) = delete;
+    OrderTable& operator=(const OrderTable&) = delete;
+
+    void Reserve(size_t);
+    std::pair<Order*, bool> Emplace(const Id, const Order&);
+    void Erase(const Id);
+    size_t Size() const;
+    size_t GetPageCount() const;
+
+    Order* Find(const Id id)
+    {
+        Id page = id >> kPageShift;
+        if (page - mFirstPage >= mEndPage - mFirstPage)
+        {
+            return nullptr;
+        }
+        Page* p = mPages[page & mPageMask];
+        size_t slot = id & (kPageSize - 1);
+        return p != nullptr && p->mLive[slot] ? &p->mOrders[slot] : nullptr;
+    }
+
+private:
+    struct Page
+    {
+        Order mOrders[kPageSize];
+        std::bitset<kPageSize> mLive;
+        size_t mLiveCount = 0;
+    };
+
+    Page* AcquirePage();
+    void RetirePage(Id page);
+    void GrowDirectory(size_t);
+
+    std::pmr::memory_resource* mResource;
+    std::pmr::vector<Page*> mPages;      // ring indexed by page & mPageMask
+    std::pmr::vector<Page*> mFreePages;  // retired pages ready to be reused
+    Id mPageMask = 0;
+    Id mFirstPage = 0;                   // oldest page still in the ring
+    Id mEndPage = 0;                     // one past the newest page in the ring
+    size_t mSize = 0;
+    size_t mPageCount = 0;
+};
@@ -0,0 +1,169 @@
+#include "risk.h"
+#include <algorithm>
+#include <iostream>
+
+RiskChecker::RiskChecker(size_t accounts, double priceBand, size_t openOrders) :
+    mPriceBand(priceBand),
+    mMaxOrderVolume(accounts, 0),
+    mMaxOrderNotional(accounts, 0.0),
+    mMaxPosition(accounts, 0),
+    mCreditLimit(accounts, 0.0),
+    mMaxSweepVolume(accounts, 0),
+    mPositions(accounts, 0),
+    mPositionCost(accounts, 0.0),
+    mOpenBuyVolume(accounts, 0),
+    mOpenSellVolume(accounts, 0),
+    mOpenBuyNotional(accounts, 0.0),
+    mOpenSellNotional(accounts, 0.0)
+{
+    // open orders change on every accept, fill and cancel, never rehash on that path
+    mOpenOrders.reserve(openOrders);
+}
+
+void RiskChecker::SetLimits(const AccountId account, const RiskLimits& limits)
+{
+    if (account >= mMaxOrderVolume.size())
+    {
+        std::cout << "[WARN] Could not find account while calling SetLimits with account=" << account << std::endl;
+        return;
+    }
+    mMaxOrderVolume[account] = limits.mMaxOrderVolume;
+    mMaxOrderNotional[account] = limits.mMaxOrderNotional;
+    mMaxPosition[account] = limits.mMaxPosition;
+    mCreditLimit[account] = limits.mCreditLimit;
+    mMaxSweepVolume[account] = limits.mMaxSweepVolume;
+}
+
+void RiskChecker::OnOrderAdded(const AccountId account, const Id id, const Side side, const Price price, const Volume volume)
+{
+    if (account >= mPositions.size())
+    {
+        std::cout << "[WARN] Could not find account while calling OnOrderAdded with account=" << account << std::endl;
+        return;
+    }
+    if (!mOpenOrders.emplace(id, OpenOrder{ account, side, price, volume }).second)
+    {
+        std::cout << "[WARN] Order already open while calling OnOrderAdded with id=" << id << std::endl;
+        return;
+    }
+    if (side == Side::Bid)
+    {
+        mOpenBuyVolume[account] += volume;
+        mOpenBuyNotional[account] += price * volume;
+    }
+    else
+    {
+        mOpenSellVolume[account] += volume;
+        mOpenSellNotional[account] += price * volume;
+    }
+}
+
+void RiskChecker::OnOrderDeleted(const Id id)
+{
+    auto it = mOpenOrders.find(id);
+    if (it == mOpenOrders.end())
+    {
+        return;
+    }
+    Release(it->second, it->second.mVolume);
+    mOpenOrders.erase(it);
+}
+
+void RiskChecker::OnTrade(const Order& bidOrder, const Order& askOrder, const Price price, const Volume volume)
+{
+    for (const Order* order : { &bidOrder, &askOrder })
+    {
+        auto it = mOpenOrders.find(order->mId);
+        if (it == mOpenOrders.end())
+        {
+            continue;
+        }
+        auto& openOrder = it->second;
+        const AccountId account = openOrder.mAccount;
+        const int64_t sign = openOrder.mSide == Side::Bid ? 1 : -1;
+        mPositions[account] += sign * static_cast<int64_t>(volume);
+        mPositionCost[account] += sign * price * volume;
+
+        Release(openOrder, volume);
+        openOrder.mVolume -= volume;
+        if (openOrder.mVolume == 0)
+        {
+            mOpenOrders.erase(it);
+        }
+    }
+    mLastTradePrice = price;
+}
+
+void RiskChecker::Release(const OpenOrder& order, const Volume volume)
+{
+    // open notional is released at the order price it was opened with
+    if (order.mSide == Side::Bid)
+    {
+        mOpenBuyVolume[order.mAccount] -= volume;
+        mOpenBuyNotional[order.mAccount] -= order.mPrice * volume;
+    }
+    else
+    {
+        mOpenSellVolume[order.mAccount] -= volume;
+        mOpenSellNotional[order.mAccount] -= order.mPrice * volume;
+    }
+}
+
+int64_t RiskChecker::GetPosition(const AccountId account) const
+{
+    return mPositions[account];
+}
+
+double RiskChecker::GetUsedCredit(const AccountId account) const
+{
+    // worst case of the buy and the sell side, see Check
+    double buy = mPositionCost[account] + mOpenBuyNotional[account];
+    double sell = mOpenSellNotional[account] - mPositionCost[account];
+    return std::max({ buy, sell, 0.0 });
+}
+
+std::optional<Price> RiskChecker::GetLastTradePrice() const
+{
+    return mLastTradePrice;
+}
+
+const RiskChecker::OpenOrder* RiskChecker::FindOpenOrder(const Id id) const
+{
+    auto it = mOpenOrders.find(id);
+    return it == mOpenOrders.end() ? nullptr : &it->second;
+}
+
+std::ostream& operator<<(std::ostream& os, const RiskResult& result)
+{
+    switch (result)
+    {
+        case RiskResult::Accepted:
+            os << "ACCEPTED";
+            break;
+        case RiskResult::UnknownAccount:
+            os << "UNKNOWN_ACCOUNT";
+            break;
+        case RiskResult::MaxVolume:
+            os << "MAX_VOLUME";
+            break;
+        case RiskResult::MaxNotional:
+            os << "MAX_NOTIONAL";
+            break;
+        case RiskResult::PriceBand:
+            os << "PRICE_BAND";
+            break;
+        case RiskResult::MaxPosition:
+            os << "MAX_POSITION";
+            break;
+        case RiskResult::CreditLimit:
+            os << "CREDIT_LIMIT";
+            break;
+        case RiskResult::MaxSweepVolume:
+            os << "MAX_SWEEP_VOLUME";
+            break;
+        case RiskResult::UnknownOrder:
+            os << "UNKNOWN_ORDER";
+            break;
+    }
+    return os;
+}
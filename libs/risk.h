@@ -0,0 +1,293 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include "order.h"
+
+using AccountId = uint32_t;
+
+enum class RiskResult { Accepted, UnknownAccount, MaxVolume, MaxNotional, PriceBand, MaxPosition, CreditLimit, MaxSweepVolume, UnknownOrder };
+
+std::ostream& operator<<(std::ostream& os, const RiskResult& result);
+
+struct RiskLimits
+{
+    Volume mMaxOrderVolume;
+    double mMaxOrderNotional;
+    int64_t mMaxPosition;
+    double mCreditLimit;
+    Volume mMaxSweepVolume;
+};
+
+/**
+ * Pre-trade risk checks run inline before an order reaches the order book
+ *
+ * Checks (cheapest first, first failure wins)
+ * -> MaxVolume: order volume against the account max order size
+ * -> MaxNotional: price * volume against the account max order notional
+ * -> PriceBand: price within +/- band (fraction) of the reference price
+ *    reference is the last trade, else the BBO mid, else the best opposite price
+ * -> MaxPosition: worst case position (filled position + every open order of the
+ *    same side + this order filling) within +/- the account max position
+ * -> CreditLimit: worst case exposure of the same side against the account credit
+ *  --> buy: position cost + open buy notional + order notional
+ *  --> sell: open sell notional + order notional - position cost
+ *      so a sell reducing a long position does not use up credit
+ * -> MaxSweepVolume: volume the order would execute right away (sweep of the
+ *    opposite side up to the order price) against the account max sweep
+ *
+ * Order lifecycle
+ * -> OnOrderAdded(account, id, ...) opens exposure for an accepted order
+ * -> OnTrade(bidOrder, askOrder, price, volume) moves filled volume from open
+ *    exposure into the position (position cost at the trade price)
+ * -> OnOrderDeleted(id) releases what is left open
+ * -> CheckModify(book, id, price, volume) checks the replacement of an open
+ *    order, its current open exposure does not count against the replacement
+ * -> RiskCheckedOrderBook below drives all of them from an order book
+ *
+ * Notes
+ * -> limits and per account state live in flat arrays indexed by account id
+ *    accounts start with zero limits (every order rejected) until SetLimits
+ * -> Check only reads the book, a rejected order never touches the book
+ * -> orders the checker was not told about (added to the book directly) are ignored
+ * -> the open order index is reserved for openOrders at construction so accepts,
+ *    fills and cancels do not rehash while within it
+ */
+
+class RiskChecker
+{
+public:
+    struct OpenOrder
+    {
+        AccountId mAccount;
+        Side mSide;
+        Price mPrice;
+        Volume mVolume;
+    };
+
+    RiskChecker(size_t accounts, double priceBand, size_t openOrders = 1000);
+    void SetLimits(const AccountId, const RiskLimits&);
+    void OnOrderAdded(const AccountId, const Id, const Side, const Price, const Volume);
+    void OnOrderDeleted(const Id);
+    void OnTrade(const Order& bidOrder, const Order& askOrder, const Price, const Volume);
+
+    int64_t GetPosition(const AccountId) const;
+    double GetUsedCredit(const AccountId) const;
+    std::optional<Price> GetLastTradePrice() const;
+    const OpenOrder* FindOpenOrder(const Id) const;
+
+    template<class Book>
+    RiskResult Check(const Book& book, const AccountId account, const Side side, const Price price, const Volume volume) const
+    {
+        return Check(book, account, side, price, volume, nullptr);
+    }
+
+    template<class Book>
+    RiskResult CheckModify(const Book& book, const Id id, const Price price, const Volume volume) const
+    {
+        const OpenOrder* replaced = FindOpenOrder(id);
+        if (replaced == nullptr)
+        {
+            return RiskResult::UnknownOrder;
+        }
+        return Check(book, replaced->mAccount, replaced->mSide, price, volume, replaced);
+    }
+
+private:
+    // replaced: open order going away with this order, its exposure is not counted
+    template<class Book>
+    RiskResult Check(const Book& book, const AccountId account, const Side side, const Price price, const Volume volume, const OpenOrder* replaced) const
+    {
+        if (account >= mMaxOrderVolume.size())
+        {
+            return RiskResult::UnknownAccount;
+        }
+        if (volume > mMaxOrderVolume[account])
+        {
+            return RiskResult::MaxVolume;
+        }
+        const double notional = price * volume;
+        if (notional > mMaxOrderNotional[account])
+        {
+            return RiskResult::MaxNotional;
+        }
+
+        auto reference = GetReferencePrice(book, side);
+        if (reference && std::abs(price - *reference) > mPriceBand * *reference)
+        {
+            return RiskResult::PriceBand;
+        }
+
+        const Volume replacedVolume = replaced != nullptr ? replaced->mVolume : 0;
+        const double replacedNotional = replaced != nullptr ? replaced->mPrice * replaced->mVolume : 0.0;
+        if (side == Side::Bid)
+        {
+            if (mPositions[account] + static_cast<int64_t>(mOpenBuyVolume[account] - replacedVolume + volume) > mMaxPosition[account])
+            {
+                return RiskResult::MaxPosition;
+            }
+            if (mPositionCost[account] + mOpenBuyNotional[account] - replacedNotional + notional > mCreditLimit[account])
+            {
+                return RiskResult::CreditLimit;
+            }
+        }
+        else
+        {
+            if (mPositions[account] - static_cast<int64_t>(mOpenSellVolume[account] - replacedVolume + volume) < -mMaxPosition[account])
+            {
+                return RiskResult::MaxPosition;
+            }
+            if (mOpenSellNotional[account] - replacedNotional + notional - mPositionCost[account] > mCreditLimit[account])
+            {
+                return RiskResult::CreditLimit;
+            }
+        }
+
+        if (std::min(volume, book.GetSweepVolume(side, price)) > mMaxSweepVolume[account])
+        {
+            return RiskResult::MaxSweepVolume;
+        }
+        return RiskResult::Accepted;
+    }
+
+    void Release(const OpenOrder&, const Volume);
+
+    template<class Book>
+    std::optional<Price> GetReferencePrice(const Book& book, const Side side) const
+    {
+        if (mLastTradePrice)
+        {
+            return mLastTradePrice;
+        }
+        auto bestBid = book.GetBestBid();
+        auto bestAsk = book.GetBestAsk();
+        if (bestBid && bestAsk)
+        {
+            return (*bestBid + *bestAsk) / 2;
+        }
+        return side == Side::Bid ? bestAsk : bestBid;
+    }
+
+    double mPriceBand;
+    std::optional<Price> mLastTradePrice;
+    absl::flat_hash_map<Id, OpenOrder> mOpenOrders;
+
+    // limits
+    std::vector<Volume> mMaxOrderVolume;
+    std::vector<double> mMaxOrderNotional;
+    std::vector<int64_t> mMaxPosition;
+    std::vector<double> mCreditLimit;
+    std::vector<Volume> mMaxSweepVolume;
+
+    // per account state
+    std::vector<int64_t> mPositions;
+    std::vector<double> mPositionCost;     // signed, buys add and sells subtract price * volume
+    std::vector<Volume> mOpenBuyVolume;
+    std::vector<Volume> mOpenSellVolume;
+    std::vector<double> mOpenBuyNotional;  // at the order prices
+    std::vector<double> mOpenSellNotional;
+};
+
+/**
+ * Order entry through the risk checker
+ * -> AddOrder runs Check and only passes accepted orders on to the book
+ * -> ModifyOrder runs CheckModify and moves the open exposure from the old id
+ *    to the id the book hands out for the replacement
+ * -> takes over the trade callback of the book to keep the checker up to date,
+ *    use SetOnTradeCallback on the wrapper to still receive trades
+ * -> SetOnBookUpdateCallback goes straight to the book, so
+ *    PublishMarketData(riskCheckedOrderBook, writer) publishes without
+ *    disconnecting the checker
+ */
+template<class Book>
+class RiskCheckedOrderBook
+{
+public:
+    RiskCheckedOrderBook(Book& book, RiskChecker& riskChecker) :
+        mBook(book),
+        mRiskChecker(riskChecker)
+    {
+        mBook.SetOnTradeCallback([this](const Order& bidOrder, const Order& askOrder, Volume volume, Price price, Side aggressorSide)
+        {
+            mRiskChecker.OnTrade(bidOrder, askOrder, price, volume);
+            if (mOnTradeCallback)
+            {
+                mOnTradeCallback(bidOrder, askOrder, volume, price, aggressorSide);
+            }
+        });
+    }
+
+    std::pair<RiskResult, std::optional<Id>> AddOrder(const AccountId account, const Side side, const Price price, const Volume volume)
+    {
+        RiskResult result = mRiskChecker.Check(mBook, account, side, price, volume);
+        if (result != RiskResult::Accepted)
+        {
+            std::cout << "[WARN] Rejected order account=" << account << " side=" << side << " price=" << price
+                      << " volume=" << volume << " result=" << result << std::endl;
+            return { result, std::nullopt };
+        }
+
+        // open the exposure first, the order can trade inside AddOrder
+        Id id = mBook.GetNextId();
+        mRiskChecker.OnOrderAdded(account, id, side, price, volume);
+        auto added = mBook.AddOrder(side, price, volume);
+        if (!added)
+        {
+            mRiskChecker.OnOrderDeleted(id);
+        }
+        return { result, added };
+    }
+
+    std::pair<RiskResult, std::optional<Id>> ModifyOrder(const Id id, const Price price, const Volume volume)
+    {
+        RiskResult result = mRiskChecker.CheckModify(mBook, id, price, volume);
+        if (result != RiskResult::Accepted)
+        {
+            std::cout << "[WARN] Rejected modify id=" << id << " price=" << price << " volume=" << volume << " result=" << result << std::endl;
+            return { result, std::nullopt };
+        }
+
+        // the book deletes the old id and adds the replacement under the next id, which can trade right away
+        const RiskChecker::OpenOrder replaced = *mRiskChecker.FindOpenOrder(id);
+        Id newId = mBook.GetNextId();
+        mRiskChecker.OnOrderDeleted(id);
+        mRiskChecker.OnOrderAdded(replaced.mAccount, newId, replaced.mSide, price, volume);
+        if (!mBook.ModifyOrder(id, price, volume))
+        {
+            mRiskChecker.OnOrderDeleted(newId);
+            return { result, std::nullopt };
+        }
+        return { result, newId };
+    }
+
+    bool DeleteOrder(const Id id)
+    {
+        if (!mBook.DeleteOrder(id))
+        {
+            return false;
+        }
+        mRiskChecker.OnOrderDeleted(id);
+        return true;
+    }
+
+    void SetOnTradeCallback(OnTradeCallback callback)
+    {
+        mOnTradeCallback = std::move(callback);
+    }
+
+    void SetOnBookUpdateCallback(OnBookUpdateCallback callback)
+    {
+        mBook.SetOnBookUpdateCallback(std::move(callback));
+    }
+
+private:
+    Book& mBook;
+    RiskChecker& mRiskChecker;
+    OnTradeCallback mOnTradeCallback;
+};
+
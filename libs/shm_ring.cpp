@@ -0,0 +1,161 @@
+#include "shm_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr uint64_t kMagic = 0x4d4452494e473031; // "MDRING01"
+
+    size_t GetSegmentSize(uint64_t capacity)
+    {
+        return sizeof(ShmRingHeader) + capacity * sizeof(ShmRingSlot);
+    }
+}
+
+ShmRingWriter::ShmRingWriter(const std::string& name, size_t capacity) :
+    mName(name)
+{
+    uint64_t slots = 2;
+    while (slots < capacity)
+    {
+        slots *= 2;
+    }
+    mSize = GetSegmentSize(slots);
+
+    // never take over an existing segment, its readers would silently see an empty ring
+    int fd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        std::cout << "[ERROR] Failed to create shared memory ring with name=" << mName
+                  << (errno == EEXIST ? ", it already exists (another writer, or left over by one that crashed: remove /dev/shm" + mName + ")" : "")
+                  << std::endl;
+        return;
+    }
+    void* memory = ftruncate(fd, mSize) == 0 ? mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        std::cout << "[ERROR] Failed to map shared memory ring with name=" << mName << " size=" << mSize << std::endl;
+        shm_unlink(mName.c_str());
+        return;
+    }
+
+    // ftruncate zero fills the segment, every slot starts out empty (sequence 0)
+    mHeader = new (memory) ShmRingHeader{};
+    mHeader->mCapacity = slots;
+    mHeader->mWriteSequence.store(0, std::memory_order_relaxed);
+    mSlots = reinterpret_cast<ShmRingSlot*>(mHeader + 1);
+    mMask = slots - 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    mHeader->mMagic = kMagic;
+}
+
+ShmRingWriter::~ShmRingWriter()
+{
+    if (mHeader != nullptr)
+    {
+        // readers still attached to the (now unlinked) segment see Closed instead of Empty forever
+        mHeader->mClosed.store(1, std::memory_order_release);
+        munmap(mHeader, mSize);
+        shm_unlink(mName.c_str());
+    }
+}
+
+bool ShmRingWriter::IsOpen() const
+{
+    return mHeader != nullptr;
+}
+
+uint64_t ShmRingWriter::GetWriteSequence() const
+{
+    return mSequence;
+}
+
+ShmRingReader::ShmRingReader(const std::string& name, bool fromLatest)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        std::cout << "[ERROR] Failed to open shared memory ring with name=" << name << std::endl;
+        return;
+    }
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(ShmRingHeader))
+    {
+        mSize = info.st_size;
+        memory = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        std::cout << "[ERROR] Failed to map shared memory ring with name=" << name << std::endl;
+        return;
+    }
+
+    auto* header = static_cast<const ShmRingHeader*>(memory);
+    if (header->mMagic != kMagic || GetSegmentSize(header->mCapacity) != mSize)
+    {
+        std::cout << "[ERROR] Shared memory ring with name=" << name << " is not initialized" << std::endl;
+        munmap(memory, mSize);
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    mHeader = header;
+    mSlots = reinterpret_cast<const ShmRingSlot*>(header + 1);
+    mMask = header->mCapacity - 1;
+    uint64_t writeSequence = mHeader->mWriteSequence.load(std::memory_order_acquire);
+    if (fromLatest)
+    {
+        mCursor = writeSequence;
+    }
+    else
+    {
+        mCursor = writeSequence > header->mCapacity ? writeSequence - header->mCapacity : 0;
+    }
+}
+
+ShmRingReader::~ShmRingReader()
+{
+    if (mHeader != nullptr)
+    {
+        munmap(const_cast<ShmRingHeader*>(mHeader), mSize);
+    }
+}
+
+bool ShmRingReader::IsOpen() const
+{
+    return mHeader != nullptr;
+}
+
+uint64_t ShmRingReader::GetCursor() const
+{
+    return mCursor;
+}
+
+uint64_t ShmRingReader::GetLost() const
+{
+    return mLost;
+}
+
+void ShmRingReader::Resync()
+{
+    // skip to the oldest record still in the ring, leaving a few slots of room
+    // for the writer to keep going while the reader catches up
+    uint64_t writeSequence = mHeader->mWriteSequence.load(std::memory_order_acquire);
+    uint64_t capacity = mMask + 1;
+    uint64_t margin = std::max<uint64_t>(capacity / 8, 1);
+    uint64_t oldest = writeSequence > capacity - margin ? writeSequence - (capacity - margin) : 0;
+    if (oldest > mCursor)
+    {
+        mLost += oldest - mCursor;
+        mCursor = oldest;
+    }
+}
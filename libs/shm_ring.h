@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "order.h"
+
+/**
+ * Shared memory ring publishing market data to local processes
+ *
+ * Usage
+ * -> matching process: ShmRingWriter writer("/md", capacity); PublishMarketData(orderBook, writer)
+ *    (or PublishMarketData(riskCheckedOrderBook, writer))
+ * -> consumer process: ShmRingReader reader("/md"); reader.Read(record)
+ *
+ * Layout (POSIX shared memory object)
+ * -> header with the capacity and the sequence of the next record to write
+ * -> capacity slots (power of two), record n lives in slot n & (capacity - 1)
+ * -> every slot carries its own sequence word (seqlock)
+ *  --> 2n + 1 while record n is being written, 2n + 2 once it is complete
+ *
+ * Notes
+ * -> single writer, any number of readers, readers never write to the segment
+ * -> the writer creates the segment exclusively (a second writer fails to open)
+ *    and marks it closed on destruction, readers then get Closed once they
+ *    have read everything that was published
+ * -> every reader keeps its own cursor, a slow reader never blocks the writer
+ * -> a reader detects an overrun when the slot it wants already holds a newer
+ *    record (or changed while being copied), it then skips to the oldest record
+ *    still in the ring (less a margin of capacity / 8 slots the writer may be
+ *    overwriting) and counts the records it lost
+ * -> records are fixed size and trivially copyable, publishing is a store of
+ *    the slot sequence, a copy of the record and a second store
+ */
+
+enum class RecordType : uint8_t { Trade, BookUpdate };
+
+struct MarketDataRecord
+{
+    RecordType mType;
+    Side mSide;        // Trade: side of the aggressive order, BookUpdate: side of the level
+    Id mBidId;         // Trade: bid order id
+    Id mAskId;         // Trade: ask order id
+    Price mPrice;      // Trade: price of the resting order, BookUpdate: level price
+    Volume mVolume;    // Trade: matched volume, BookUpdate: level volume after the update (0 when removed)
+};
+
+static_assert(std::is_trivially_copyable_v<MarketDataRecord>);
+
+enum class ReadResult { Ok, Empty, Overrun, Closed };
+
+struct alignas(64) ShmRingHeader
+{
+    uint64_t mMagic;
+    uint64_t mCapacity;
+    std::atomic<uint64_t> mClosed;  // set once the writer is gone
+    alignas(64) std::atomic<uint64_t> mWriteSequence;
+};
+
+struct alignas(64) ShmRingSlot
+{
+    std::atomic<uint64_t> mSequence;
+    MarketDataRecord mRecord;
+};
+
+// atomics in shared memory must not fall back to a process local lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+class ShmRingWriter
+{
+public:
+    ShmRingWriter(const std::string& name, size_t capacity);
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    bool IsOpen() const;
+    uint64_t GetWriteSequence() const;
+
+    void Publish(const MarketDataRecord& record)
+    {
+        auto& slot = mSlots[mSequence & mMask];
+        slot.mSequence.store(2 * mSequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.mRecord = record;
+        slot.mSequence.store(2 * mSequence + 2, std::memory_order_release);
+        mHeader->mWriteSequence.store(++mSequence, std::memory_order_release);
+    }
+
+private:
+    std::string mName;
+    size_t mSize = 0;
+    ShmRingHeader* mHeader = nullptr;
+    ShmRingSlot* mSlots = nullptr;
+    uint64_t mMask = 0;
+    uint64_t mSequence = 0;
+};
+
+class ShmRingReader
+{
+public:
+    explicit ShmRingReader(const std::string& name, bool fromLatest = true);
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    bool IsOpen() const;
+    uint64_t GetCursor() const;
+    uint64_t GetLost() const;
+
+    ReadResult Read(MarketDataRecord& record)
+    {
+        const auto& slot = mSlots[mCursor & mMask];
+        const uint64_t expected = 2 * mCursor + 2;
+        uint64_t before = slot.mSequence.load(std::memory_order_acquire);
+        if (before < expected)
+        {
+            // not written yet (or still being written)
+            if (!mHeader->mClosed.load(std::memory_order_acquire))
+            {
+                return ReadResult::Empty;
+            }
+            // the writer may have published the record right before closing
+            before = slot.mSequence.load(std::memory_order_acquire);
+            if (before < expected)
+            {
+                return ReadResult::Closed;
+            }
+        }
+        record = slot.mRecord;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.mSequence.load(std::memory_order_relaxed);
+        if (before != expected || after != expected)
+        {
+            Resync();
+            return ReadResult::Overrun;
+        }
+        mCursor++;
+        return ReadResult::Ok;
+    }
+
+private:
+    void Resync();
+
+    size_t mSize = 0;
+    const ShmRingHeader* mHeader = nullptr;
+    const ShmRingSlot* mSlots = nullptr;
+    uint64_t mMask = 0;
+    uint64_t mCursor = 0;
+    uint64_t mLost = 0;
+};
+
+/**
+ * Publishes the trades and level updates of an order book to the ring
+ * -> replaces the trade and book update callbacks of the order book
+ * -> pass the RiskCheckedOrderBook instead of the book it wraps when orders
+ *    go through the risk checker, it keeps its own trade callback
+ */
+template<class Book>
+void PublishMarketData(Book& book, ShmRingWriter& writer)
+{
+    if (!writer.IsOpen())
+    {
+        std::cout << "[WARN] Shared memory ring is not open, market data will not be published" << std::endl;
+        return;
+    }
+    book.SetOnTradeCallback([&writer](const Order& bidOrder, const Order& askOrder, Volume volume, Price price, Side aggressorSide)
+    {
+        writer.Publish(MarketDataRecord{ RecordType::Trade, aggressorSide, bidOrder.mId, askOrder.mId, price, volume });
+    });
+    book.SetOnBookUpdateCallback([&writer](Side side, Price price, Volume volume)
+    {
+        writer.Publish(MarketDataRecord{ RecordType::BookUpdate, side, 0, 0, price, volume });
+    });
+}
@@ -0,0 +1,61 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+
+namespace
+{
+    std::atomic<size_t> gAllocations{ 0 };
+
+    void* Allocate(size_t size)
+    {
+        gAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* AllocateAligned(size_t size, std::align_val_t alignment)
+    {
+        gAllocations.fetch_add(1, std::memory_order_relaxed);
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size_t align = static_cast<size_t>(alignment);
+        size_t rounded = (std::max<size_t>(size, 1) + align - 1) & ~(align - 1);
+        return std::aligned_alloc(align, rounded);
+    }
+
+    void* AllocateOrThrow(void* p)
+    {
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+size_t GetAllocationCount()
+{
+    return gAllocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) { return AllocateOrThrow(Allocate(size)); }
+void* operator new[](size_t size) { return AllocateOrThrow(Allocate(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateOrThrow(AllocateAligned(size, alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateOrThrow(AllocateAligned(size, alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Test hook counting every call to the replaceable global operator new
+ * -> all forms are replaced (plain, array, nothrow, aligned) in allocation_counter.cpp
+ * -> used to assert that the order book hot path never reaches malloc
+ */
+
+size_t GetAllocationCount();
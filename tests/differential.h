@@ -0,0 +1,486 @@
+#pragma once
+#include "order_book.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Differential testing of the order book against a reference implementation
+ *
+ * -> ReferenceOrderBook is a deliberately simple book (std::map of price to
+ *    std::deque of orders) with the same price-time priority semantics
+ * -> a sequence of Commands runs through both books side by side, after every
+ *    command the trades it produced and the visible book state must match
+ * -> RunInvariants checks book invariants alone, for the pro-rata policies
+ * -> failing sequences are shrunk with Minimize before being reported
+ *
+ * Used by test_differential.cpp (randomized sequences) and
+ * fuzz_order_book.cpp (libFuzzer entry point)
+ */
+
+enum class CommandType { Add, Modify, Delete };
+
+struct Command
+{
+    CommandType mType;
+    Side mSide;
+    Price mPrice;
+    Volume mVolume;
+    Id mId;
+};
+
+struct Trade
+{
+    Id mBidId;
+    Id mAskId;
+    Volume mBidVolume;
+    Volume mAskVolume;
+    Volume mVolume;
+    Price mPrice;          // price of the resting order
+    Side mAggressorSide;
+
+    bool operator==(const Trade& other) const
+    {
+        return mBidId == other.mBidId && mAskId == other.mAskId && mBidVolume == other.mBidVolume &&
+               mAskVolume == other.mAskVolume && mVolume == other.mVolume && mPrice == other.mPrice &&
+               mAggressorSide == other.mAggressorSide;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Command& command)
+{
+    switch (command.mType)
+    {
+        case CommandType::Add:
+            return os << "add_order " << command.mSide << " " << command.mVolume << " " << command.mPrice;
+        case CommandType::Modify:
+            return os << "modify_order " << command.mId << " " << command.mVolume << " " << command.mPrice;
+        case CommandType::Delete:
+            return os << "delete_order " << command.mId;
+    }
+    return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Trade& trade)
+{
+    return os << "(bid=" << trade.mBidId << " ask=" << trade.mAskId << " bidVolume=" << trade.mBidVolume
+              << " askVolume=" << trade.mAskVolume << " volume=" << trade.mVolume << " price=" << trade.mPrice
+              << " aggressor=" << trade.mAggressorSide << ")";
+}
+
+class ReferenceOrderBook
+{
+public:
+    using TradeCallback = std::function<void(const Trade&)>;
+
+    void SetOnTradeCallback(TradeCallback callback)
+    {
+        mOnTrade = std::move(callback);
+    }
+
+    Id AddOrder(const Side side, const Price price, const Volume volume)
+    {
+        Id id = mId++;
+        mOrders[id] = Order{ id, side, price, volume };
+        (side == Side::Bid ? mBids : mAsks)[price].push_back(id);
+        MatchOrders(side);
+        return id;
+    }
+
+    bool ModifyOrder(const Id id, const Price price, const Volume volume)
+    {
+        auto it = mOrders.find(id);
+        if (it == mOrders.end())
+        {
+            return false;
+        }
+        Side side = it->second.mSide;
+        DeleteOrder(id);
+        AddOrder(side, price, volume);
+        return true;
+    }
+
+    bool DeleteOrder(const Id id)
+    {
+        auto it = mOrders.find(id);
+        if (it == mOrders.end())
+        {
+            return false;
+        }
+        auto& levels = it->second.mSide == Side::Bid ? mBids : mAsks;
+        auto level = levels.find(it->second.mPrice);
+        level->second.erase(std::find(level->second.begin(), level->second.end(), id));
+        if (level->second.empty())
+        {
+            levels.erase(level);
+        }
+        mOrders.erase(it);
+        return true;
+    }
+
+    const Order* FindOrder(const Id id) const
+    {
+        auto it = mOrders.find(id);
+        return it == mOrders.end() ? nullptr : &it->second;
+    }
+
+    std::optional<Price> GetBestBid() const
+    {
+        return mBids.empty() ? std::nullopt : std::optional<Price>(mBids.rbegin()->first);
+    }
+
+    std::optional<Price> GetBestAsk() const
+    {
+        return mAsks.empty() ? std::nullopt : std::optional<Price>(mAsks.begin()->first);
+    }
+
+    Volume GetSweepVolume(const Side side, const Price price) const
+    {
+        Volume volume = 0;
+        for (const auto& [id, order] : mOrders)
+        {
+            if (order.mSide != side && (side == Side::Bid ? order.mPrice <= price : order.mPrice >= price))
+            {
+                volume += order.mVolume;
+            }
+        }
+        return volume;
+    }
+
+    Id GetNextId() const
+    {
+        return mId;
+    }
+
+private:
+    void MatchOrders(const Side aggressorSide)
+    {
+        while (!mBids.empty() && !mAsks.empty() && mBids.rbegin()->first >= mAsks.begin()->first)
+        {
+            auto bidLevel = std::prev(mBids.end());
+            auto askLevel = mAsks.begin();
+            auto& bid = mOrders[bidLevel->second.front()];
+            auto& ask = mOrders[askLevel->second.front()];
+
+            Volume volume = std::min(bid.mVolume, ask.mVolume);
+            if (mOnTrade)
+            {
+                Price price = aggressorSide == Side::Bid ? ask.mPrice : bid.mPrice;
+                mOnTrade(Trade{ bid.mId, ask.mId, bid.mVolume, ask.mVolume, volume, price, aggressorSide });
+            }
+            bid.mVolume -= volume;
+            ask.mVolume -= volume;
+
+            if (bid.mVolume == 0)
+            {
+                mOrders.erase(bid.mId);
+                bidLevel->second.pop_front();
+            }
+            if (ask.mVolume == 0)
+            {
+                mOrders.erase(ask.mId);
+                askLevel->second.pop_front();
+            }
+            if (bidLevel->second.empty())
+            {
+                mBids.erase(bidLevel);
+            }
+            if (askLevel->second.empty())
+            {
+                mAsks.erase(askLevel);
+            }
+        }
+    }
+
+    Id mId = 0;
+    TradeCallback mOnTrade;
+    std::map<Id, Order> mOrders;
+    std::map<Price, std::deque<Id>> mBids;
+    std::map<Price, std::deque<Id>> mAsks;
+};
+
+/**
+ * Generates a random command sequence
+ * -> prices on a narrow tick grid so that books cross often
+ * -> modify/delete target ids around the ones already handed out,
+ *    including ids which are already filled or deleted
+ */
+inline std::vector<Command> GenerateCommands(std::mt19937_64& rng, size_t count)
+{
+    std::uniform_int_distribution<int> type(0, 9);
+    std::uniform_int_distribution<int> tick(0, 20);
+    std::uniform_int_distribution<Volume> volume(1, 20);
+
+    std::vector<Command> commands;
+    commands.reserve(count);
+    Id ids = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Command command{ CommandType::Add, rng() % 2 ? Side::Bid : Side::Ask, 95.0 + tick(rng) * 0.5, volume(rng), 0 };
+        int roll = type(rng);
+        if (ids > 0 && roll >= 5)
+        {
+            command.mType = roll >= 8 ? CommandType::Modify : CommandType::Delete;
+            command.mId = rng() % (ids + 2);
+        }
+        ids += command.mType != CommandType::Delete;
+        commands.push_back(command);
+    }
+    return commands;
+}
+
+/**
+ * Runs commands through both books and returns a description of the first
+ * divergence (empty string if both books agree on every step)
+ */
+template<class Book>
+std::string RunDifferential(const std::vector<Command>& commands)
+{
+    // order book logs every update, keep the harness fast and quiet
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    Book book;
+    ReferenceOrderBook reference;
+    std::vector<Trade> trades;
+    std::vector<Trade> referenceTrades;
+    book.SetOnTradeCallback([&](const Order& bid, const Order& ask, Volume volume, Price price, Side aggressorSide)
+    {
+        trades.push_back(Trade{ bid.mId, ask.mId, bid.mVolume, ask.mVolume, volume, price, aggressorSide });
+    });
+    reference.SetOnTradeCallback([&](const Trade& trade) { referenceTrades.push_back(trade); });
+
+    std::ostringstream error;
+    for (size_t step = 0; step < commands.size() && error.str().empty(); ++step)
+    {
+        const auto& command = commands[step];
+        trades.clear();
+        referenceTrades.clear();
+        switch (command.mType)
+        {
+            case CommandType::Add:
+            {
+                auto id = book.AddOrder(command.mSide, command.mPrice, command.mVolume);
+                Id referenceId = reference.AddOrder(command.mSide, command.mPrice, command.mVolume);
+                if (!id || *id != referenceId)
+                {
+                    error << "id=" << (id ? std::to_string(*id) : "none") << " expected=" << referenceId;
+                }
+                break;
+            }
+            case CommandType::Modify:
+            {
+                bool modified = book.ModifyOrder(command.mId, command.mPrice, command.mVolume);
+                if (modified != reference.ModifyOrder(command.mId, command.mPrice, command.mVolume))
+                {
+                    error << "modified=" << modified;
+                }
+                break;
+            }
+            case CommandType::Delete:
+            {
+                bool deleted = book.DeleteOrder(command.mId);
+                if (deleted != reference.DeleteOrder(command.mId))
+                {
+                    error << "deleted=" << deleted;
+                }
+                break;
+            }
+        }
+
+        if (trades != referenceTrades)
+        {
+            error << "trades:";
+            for (const auto& trade : trades)
+            {
+                error << " " << trade;
+            }
+            error << " expected:";
+            for (const auto& trade : referenceTrades)
+            {
+                error << " " << trade;
+            }
+        }
+        if (book.GetBestBid() != reference.GetBestBid() || book.GetBestAsk() != reference.GetBestAsk())
+        {
+            error << "best bid=" << book.GetBestBid().value_or(-1) << " ask=" << book.GetBestAsk().value_or(-1)
+                  << " expected bid=" << reference.GetBestBid().value_or(-1) << " ask=" << reference.GetBestAsk().value_or(-1);
+        }
+        for (Side side : { Side::Bid, Side::Ask })
+        {
+            Volume volume = book.GetSweepVolume(side, command.mPrice);
+            Volume expected = reference.GetSweepVolume(side, command.mPrice);
+            if (volume != expected)
+            {
+                error << "sweep side=" << side << " price=" << command.mPrice << " volume=" << volume << " expected=" << expected;
+            }
+        }
+        for (Id id = 0; id < reference.GetNextId(); ++id)
+        {
+            const Order* order = book.FindOrder(id);
+            const Order* expected = reference.FindOrder(id);
+            if ((order == nullptr) != (expected == nullptr) ||
+                (order != nullptr && (order->mSide != expected->mSide || order->mPrice != expected->mPrice || order->mVolume != expected->mVolume)))
+            {
+                error << "order id=" << id << " found=";
+                order ? error << *order : error << "none";
+                error << " expected=";
+                expected ? error << *expected : error << "none";
+                break;
+            }
+        }
+        if (!error.str().empty())
+        {
+            std::ostringstream prefix;
+            prefix << "step=" << step << " command=(" << command << ") ";
+            error.str(prefix.str() + error.str());
+        }
+    }
+
+    std::cout.rdbuf(coutBuffer);
+    return error.str();
+}
+
+/**
+ * Checks book invariants after every command, for matching policies the
+ * reference book does not model (pro-rata)
+ * -> conservation: live volume changes by the volume added/removed by the
+ *    command minus twice the traded volume, no fill exceeds either order
+ * -> the live volume of all orders equals a sweep over all levels of both sides
+ * -> the book is never crossed
+ * Returns a description of the first violation (empty string if none)
+ */
+template<class Book>
+std::string RunInvariants(const std::vector<Command>& commands)
+{
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+
+    Book book;
+    Volume traded = 0;
+    std::ostringstream error;
+    book.SetOnTradeCallback([&](const Order& bid, const Order& ask, Volume volume, Price, Side)
+    {
+        traded += volume;
+        if (volume == 0 || volume > bid.mVolume || volume > ask.mVolume)
+        {
+            error << "fill volume=" << volume << " bid=" << bid << " ask=" << ask << " ";
+        }
+    });
+    auto liveVolume = [&]()
+    {
+        Volume volume = 0;
+        for (Id id = 0; id < book.GetNextId(); ++id)
+        {
+            const Order* order = book.FindOrder(id);
+            volume += order != nullptr ? order->mVolume : 0;
+        }
+        return volume;
+    };
+
+    for (size_t step = 0; step < commands.size() && error.str().empty(); ++step)
+    {
+        const auto& command = commands[step];
+        Volume before = liveVolume();
+        Volume added = 0;
+        Volume removed = 0;
+        traded = 0;
+        const Order* existing = command.mType != CommandType::Add ? book.FindOrder(command.mId) : nullptr;
+        Volume existingVolume = existing != nullptr ? existing->mVolume : 0;
+        switch (command.mType)
+        {
+            case CommandType::Add:
+                book.AddOrder(command.mSide, command.mPrice, command.mVolume);
+                added = command.mVolume;
+                break;
+            case CommandType::Modify:
+                if (book.ModifyOrder(command.mId, command.mPrice, command.mVolume))
+                {
+                    added = command.mVolume;
+                    removed = existingVolume;
+                }
+                break;
+            case CommandType::Delete:
+                if (book.DeleteOrder(command.mId))
+                {
+                    removed = existingVolume;
+                }
+                break;
+        }
+
+        Volume after = liveVolume();
+        if (before + added != after + removed + 2 * traded)
+        {
+            error << "live volume=" << after << " before=" << before << " added=" << added << " removed=" << removed << " traded=" << traded;
+        }
+        Volume swept = book.GetSweepVolume(Side::Bid, std::numeric_limits<Price>::max()) +
+                       book.GetSweepVolume(Side::Ask, std::numeric_limits<Price>::lowest());
+        if (swept != after)
+        {
+            error << "sweep volume=" << swept << " live volume=" << after;
+        }
+        auto bestBid = book.GetBestBid();
+        auto bestAsk = book.GetBestAsk();
+        if (bestBid && bestAsk && *bestBid >= *bestAsk)
+        {
+            error << "crossed bid=" << *bestBid << " ask=" << *bestAsk;
+        }
+        if (!error.str().empty())
+        {
+            std::ostringstream prefix;
+            prefix << "step=" << step << " command=(" << command << ") ";
+            error.str(prefix.str() + error.str());
+        }
+    }
+
+    std::cout.rdbuf(coutBuffer);
+    return error.str();
+}
+
+/**
+ * Shrinks a failing sequence while it keeps failing
+ * -> drops chunks of commands, halving the chunk size down to single commands
+ * -> repeats until no single command can be removed
+ */
+template<class Predicate>
+std::vector<Command> Minimize(std::vector<Command> commands, Predicate fails)
+{
+    bool shrunk = true;
+    while (shrunk)
+    {
+        shrunk = false;
+        for (size_t chunk = std::max<size_t>(commands.size() / 2, 1); chunk > 0; chunk /= 2)
+        {
+            for (size_t start = 0; start < commands.size();)
+            {
+                std::vector<Command> candidate(commands.begin(), commands.begin() + start);
+                candidate.insert(candidate.end(), commands.begin() + std::min(start + chunk, commands.size()), commands.end());
+                if (!candidate.empty() && fails(candidate))
+                {
+                    commands = std::move(candidate);
+                    shrunk = true;
+                }
+                else
+                {
+                    start += chunk;
+                }
+            }
+        }
+    }
+    return commands;
+}
+
+inline std::string FormatCommands(const std::vector<Command>& commands)
+{
+    std::ostringstream os;
+    for (const auto& command : commands)
+    {
+        os << command << "\n";
+    }
+    return os.str();
+}
@@ -0,0 +1,71 @@
+#include "differential.h"
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * libFuzzer entry point for the differential harness
+ * -> every 5 input bytes decode into one Command
+ *  --> byte 0: command type and side
+ *  --> byte 1: price tick
+ *  --> byte 2: volume
+ *  --> bytes 3-4: target id for modify/delete, taken modulo the ids handed
+ *      out so far (+2 to also hit unknown ids) like GenerateCommands
+ * -> on divergence the sequence is minimized and printed before aborting
+ *    so the crash report contains a short reproducer
+ *
+ * Build with clang: cmake -DBUILD_FUZZERS=ON -DCMAKE_CXX_COMPILER=clang++
+ * Run: ./fuzz_order_book -max_len=4096
+ */
+
+namespace
+{
+    std::vector<Command> DecodeCommands(const uint8_t* data, size_t size)
+    {
+        std::vector<Command> commands;
+        commands.reserve(size / 5);
+        Id ids = 0;
+        for (size_t i = 0; i + 5 <= size; i += 5)
+        {
+            Id target = data[i + 3] | data[i + 4] << 8;
+            Command command{ CommandType::Add, data[i] & 1 ? Side::Ask : Side::Bid, 95.0 + (data[i + 1] % 21) * 0.5,
+                static_cast<Volume>(data[i + 2] % 20 + 1), target % (ids + 2) };
+            switch ((data[i] >> 1) % 4)
+            {
+                case 2:
+                    command.mType = CommandType::Modify;
+                    break;
+                case 3:
+                    command.mType = CommandType::Delete;
+                    break;
+                default:
+                    break;
+            }
+            ids += command.mType != CommandType::Delete;
+            commands.push_back(command);
+        }
+        return commands;
+    }
+
+    template<class Book>
+    void Check(const std::vector<Command>& commands)
+    {
+        std::string error = RunDifferential<Book>(commands);
+        if (error.empty())
+        {
+            return;
+        }
+        auto minimized = Minimize(commands, [](const auto& candidate) { return !RunDifferential<Book>(candidate).empty(); });
+        std::cerr << error << "\n"
+                  << "minimized to " << minimized.size() << " commands: " << RunDifferential<Book>(minimized) << "\n"
+                  << FormatCommands(minimized);
+        std::abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    auto commands = DecodeCommands(data, size);
+    Check<OrderBook>(commands);
+    Check<DenseOrderBook>(commands);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "differential.h"
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+/**
+ * Randomized differential tests of the order book against ReferenceOrderBook,
+ * and randomized invariant runs of the pro-rata books (see RunInvariants)
+ * -> DIFFERENTIAL_SEQUENCES scales the number of generated sequences
+ *    (e.g. DIFFERENTIAL_SEQUENCES=10000 runs a few million commands)
+ * -> DIFFERENTIAL_SEED picks the first seed, every sequence uses seed + index
+ */
+
+namespace
+{
+    constexpr size_t kCommandsPerSequence = 300;
+
+    size_t GetEnv(const char* name, size_t defaultValue)
+    {
+        const char* value = std::getenv(name);
+        return value != nullptr ? std::strtoull(value, nullptr, 10) : defaultValue;
+    }
+
+    template<class Run>
+    void RunSequences(Run run)
+    {
+        size_t sequences = GetEnv("DIFFERENTIAL_SEQUENCES", 500);
+        size_t seed = GetEnv("DIFFERENTIAL_SEED", 0);
+        for (size_t i = 0; i < sequences; ++i)
+        {
+            std::mt19937_64 rng(seed + i);
+            auto commands = GenerateCommands(rng, kCommandsPerSequence);
+            std::string error = run(commands);
+            if (!error.empty())
+            {
+                auto minimized = Minimize(commands, [&](const auto& candidate) { return !run(candidate).empty(); });
+                FAIL() << "seed=" << seed + i << " " << error << "\n"
+                       << "minimized to " << minimized.size() << " commands: " << run(minimized) << "\n"
+                       << FormatCommands(minimized);
+            }
+        }
+    }
+}
+
+TEST(DifferentialTest, OrderBook)
+{
+    RunSequences(RunDifferential<OrderBook>);
+}
+
+TEST(DifferentialTest, DenseOrderBook)
+{
+    RunSequences(RunDifferential<DenseOrderBook>);
+}
+
+TEST(DifferentialTest, ProRataInvariants)
+{
+    RunSequences(RunInvariants<ProRataOrderBook>);
+}
+
+TEST(DifferentialTest, TopOrderProRataInvariants)
+{
+    RunSequences(RunInvariants<TopOrderProRataOrderBook>);
+}
+
+TEST(DifferentialTest, MinimizeKeepsFailure)
+{
+    std::mt19937_64 rng(0);
+    auto commands = GenerateCommands(rng, 200);
+    // pretend any sequence deleting an order is a failure
+    auto fails = [](const std::vector<Command>& candidate)
+    {
+        return std::any_of(candidate.begin(), candidate.end(), [](const Command& command) { return command.mType == CommandType::Delete; });
+    };
+    ASSERT_TRUE(fails(commands));
+    auto minimized = Minimize(commands, fails);
+    ASSERT_EQ(minimized.size(), 1);
+    EXPECT_EQ(minimized.front().mType, CommandType::Delete);
+}
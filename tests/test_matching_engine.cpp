@@ -1,5 +1,16 @@
 #include "order_book.h"
+#include "allocation_counter.h"
+#include "arena.h"
+#include "risk.h"
+#include "shm_ring.h"
+#include <deque>
+#include <memory>
 #include <queue>
+#include <numeric>
+#include <tuple>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <gtest/gtest.h>
 
 class OrderBookTest : public ::testing::Test 
@@ -7,7 +18,7 @@ class OrderBookTest : public ::testing::Test
 protected:
     void SetUp() override
     {
-        mOrderBook.SetOnTradeCallback([&](const Order& bidOrder, const Order& askOrder, Volume volume){ OnTrade(bidOrder, askOrder, volume); });
+        mOrderBook.SetOnTradeCallback([&](const Order& bidOrder, const Order& askOrder, Volume volume, Price, Side){ OnTrade(bidOrder, askOrder, volume); });
     }
 
     void TearDown() override
@@ -199,3 +210,642 @@ TEST_F(OrderBookTest, MatchOrdersAfterMultipleModifies)
     EXPECT_TRUE(mBidMatches.empty());
     EXPECT_TRUE(mAskMatches.empty());
 }
+
+TEST_F(OrderBookTest, SweepVolume)
+{
+    // BID 5@10 + BID 7@11 + BID 3@11 + BID 4@12
+    EXPECT_TRUE(mOrderBook.AddOrder(Side::Bid, 10 /*=price*/, 5 /*=volume*/));
+    EXPECT_TRUE(mOrderBook.AddOrder(Side::Bid, 11 /*=price*/, 7 /*=volume*/));
+    EXPECT_TRUE(mOrderBook.AddOrder(Side::Bid, 11 /*=price*/, 3 /*=volume*/));
+    EXPECT_TRUE(mOrderBook.AddOrder(Side::Bid, 12 /*=price*/, 4 /*=volume*/));
+
+    // ASK 2@15 + ASK 6@14
+    EXPECT_TRUE(mOrderBook.AddOrder(Side::Ask, 15 /*=price*/, 2 /*=volume*/));
+    EXPECT_TRUE(mOrderBook.AddOrder(Side::Ask, 14 /*=price*/, 6 /*=volume*/));
+
+    // aggressive asks sweep the bid side
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Ask, 13 /*=price*/), 0);
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Ask, 12 /*=price*/), 4);
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Ask, 11 /*=price*/), 14);
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Ask, 1 /*=price*/), 19);
+
+    // aggressive bids sweep the ask side
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Bid, 13 /*=price*/), 0);
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Bid, 14 /*=price*/), 6);
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Bid, 100 /*=price*/), 8);
+
+    // deleted orders do not count towards the sweep
+    EXPECT_TRUE(mOrderBook.DeleteOrder(1 /*=id*/));
+    EXPECT_EQ(mOrderBook.GetSweepVolume(Side::Ask, 11 /*=price*/), 7);
+}
+
+TEST(LevelSearchTest, MatchesStdLowerBound)
+{
+    std::vector<SimdLevel> simdLevels = { SimdLevel::Scalar, SimdLevel::Avx2 };
+    for (auto simdLevel : simdLevels)
+    {
+        if (!SetSimdLevel(simdLevel))
+        {
+            continue;
+        }
+        for (size_t count : { 0, 1, 3, 16, 17, 100, 1000 })
+        {
+            std::vector<Price> bids;
+            std::vector<Volume> volumes;
+            for (size_t i = 0; i < count; ++i)
+            {
+                bids.push_back(100.0 + i * 0.5);
+                volumes.push_back(i + 1);
+            }
+            std::vector<Price> asks(bids.rbegin(), bids.rend());
+            for (Price price = 99.0; price <= 101.0 + count * 0.5; price += 0.25)
+            {
+                size_t bidIndex = std::lower_bound(bids.begin(), bids.end(), price, BidComparator) - bids.begin();
+                size_t askIndex = std::lower_bound(asks.begin(), asks.end(), price, AskComparator) - asks.begin();
+                EXPECT_EQ(LowerBound(bids.data(), count, price, Side::Bid), bidIndex) << simdLevel;
+                EXPECT_EQ(LowerBound(asks.data(), count, price, Side::Ask), askIndex) << simdLevel;
+
+                Volume expected = std::accumulate(volumes.begin() + bidIndex, volumes.end(), Volume{ 0 });
+                EXPECT_EQ(SweepVolume(bids.data(), volumes.data(), count, price, Side::Bid), expected) << simdLevel;
+            }
+        }
+    }
+    SetSimdLevel(GetSupportedSimdLevel());
+}
+
+TEST(ArenaTest, NoAllocationsOnHotPath)
+{
+    Arena arena(64 * 1024 * 1024 /*=capacity*/, true /*=hugePages*/, false /*=lock*/);
+    OrderBook orderBook(&arena);
+    EXPECT_EQ(arena.GetCapacity(), 64 * 1024 * 1024);
+
+    // warm up: create and tear down the levels and ids used below
+    for (int round = 0; round < 2; ++round)
+    {
+        std::vector<Id> ids;
+        for (int i = 0; i < 200; ++i)
+        {
+            ids.push_back(*orderBook.AddOrder(Side::Bid, 90 + i % 10 /*=price*/, 5 /*=volume*/));
+            ids.push_back(*orderBook.AddOrder(Side::Ask, 110 + i % 10 /*=price*/, 5 /*=volume*/));
+        }
+        for (auto id : ids)
+        {
+            orderBook.DeleteOrder(id);
+        }
+        orderBook.AddOrder(Side::Ask, 1 /*=price*/, 5000 /*=volume*/);
+        orderBook.AddOrder(Side::Bid, 1000 /*=price*/, 5000 /*=volume*/);
+    }
+
+    size_t allocationsBefore = GetAllocationCount();
+    for (int i = 0; i < 100; ++i)
+    {
+        auto bid = orderBook.AddOrder(Side::Bid, 90 + i % 10 /*=price*/, 5 /*=volume*/);
+        auto ask = orderBook.AddOrder(Side::Ask, 110 + i % 10 /*=price*/, 5 /*=volume*/);
+        EXPECT_TRUE(orderBook.ModifyOrder(*bid, 95 /*=price*/, 3 /*=volume*/));
+        EXPECT_TRUE(orderBook.DeleteOrder(*ask));
+        orderBook.AddOrder(Side::Ask, 95 /*=price*/, 3 /*=volume*/); // full match
+    }
+    EXPECT_EQ(GetAllocationCount() - allocationsBefore, 0);
+    EXPECT_EQ(arena.GetUpstreamAllocations(), 0);
+    EXPECT_GT(arena.GetUsed(), 0);
+}
+
+TEST(ArenaTest, ReservesCapacityUpFront)
+{
+    OrderBook orderBook(std::pmr::get_default_resource(), OrderBookCapacity{ 5000 /*=orders*/, 10 /*=levels*/, 500 /*=ordersPerLevel*/ });
+    for (int i = 0; i < 10; ++i)
+    {
+        orderBook.AddOrder(Side::Bid, 90 + i /*=price*/, 5 /*=volume*/);
+    }
+
+    // well past the 1000 orders the index used to rehash at
+    size_t allocationsBefore = GetAllocationCount();
+    for (int i = 0; i < 4000; ++i)
+    {
+        orderBook.AddOrder(Side::Bid, 90 + i % 10 /*=price*/, 5 /*=volume*/);
+    }
+    EXPECT_EQ(GetAllocationCount() - allocationsBefore, 0);
+}
+
+TEST(ArenaTest, LongLivedLevelUnderChurn)
+{
+    Arena arena(64 * 1024 * 1024 /*=capacity*/, true /*=hugePages*/, false /*=lock*/);
+    OrderBook orderBook(&arena);
+    std::vector<Id> trades;
+    orderBook.SetOnTradeCallback([&](const Order& bidOrder, const Order&, Volume, Price, Side){ trades.push_back(bidOrder.mId); });
+
+    // the level never drains: one order rests the whole time, a window of newer orders churns behind it
+    auto resting = orderBook.AddOrder(Side::Bid, 100 /*=price*/, 5 /*=volume*/);
+    std::deque<Id> window;
+    size_t used = 0;
+    for (int i = 0; i < 200000; ++i)
+    {
+        window.push_back(*orderBook.AddOrder(Side::Bid, 100 /*=price*/, 5 /*=volume*/));
+        if (window.size() > 4)
+        {
+            EXPECT_TRUE(orderBook.DeleteOrder(window.front()));
+            window.pop_front();
+        }
+        if (i == 1000)
+        {
+            used = arena.GetUsed();
+        }
+    }
+    EXPECT_EQ(arena.GetUsed(), used);
+    EXPECT_EQ(arena.GetUpstreamAllocations(), 0);
+
+    // compaction kept the index in sync (delete finds the moved order) and time priority
+    EXPECT_TRUE(orderBook.DeleteOrder(window.front()));
+    window.pop_front();
+    Volume volume = 5 * (window.size() + 1);
+    EXPECT_EQ(orderBook.GetSweepVolume(Side::Ask, 100 /*=price*/), volume);
+    orderBook.AddOrder(Side::Ask, 100 /*=price*/, volume);
+    std::vector<Id> expected = { *resting };
+    expected.insert(expected.end(), window.begin(), window.end());
+    EXPECT_EQ(trades, expected);
+    EXPECT_EQ(orderBook.GetBestBid(), std::nullopt);
+    EXPECT_EQ(orderBook.GetBestAsk(), std::nullopt);
+}
+
+TEST(ArenaTest, ManyLevelsFitInArena)
+{
+    constexpr size_t kLevels = 20000;
+    Arena arena(64 * 1024 * 1024 /*=capacity*/, true /*=hugePages*/, false /*=lock*/);
+    OrderBook orderBook(&arena, OrderBookCapacity{ 2 * kLevels /*=orders*/, kLevels /*=levels*/ });
+    for (size_t i = 0; i < kLevels; ++i)
+    {
+        orderBook.AddOrder(Side::Bid, 100 - i * 0.001 /*=price*/, 5 /*=volume*/);
+        orderBook.AddOrder(Side::Ask, 101 + i * 0.001 /*=price*/, 5 /*=volume*/);
+    }
+    EXPECT_EQ(arena.GetUpstreamAllocations(), 0);
+    EXPECT_EQ(orderBook.GetSweepVolume(Side::Bid, 1000 /*=price*/), 5 * kLevels);
+}
+
+TEST(ArenaTest, RecyclesFreedBlocks)
+{
+    Arena arena(1 /*=capacity*/, false /*=hugePages*/);
+    void* first = arena.allocate(100);
+    arena.deallocate(first, 100);
+    size_t used = arena.GetUsed();
+    void* second = arena.allocate(128);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(arena.GetUsed(), used);
+    arena.deallocate(second, 128);
+
+    // larger than the whole pool goes upstream
+    void* large = arena.allocate(arena.GetCapacity() * 2);
+    EXPECT_EQ(arena.GetUpstreamAllocations(), 1);
+    arena.deallocate(large, arena.GetCapacity() * 2);
+}
+
+TEST(OrderTableTest, RecyclesRetiredPages)
+{
+    OrderTable orderTable;
+    constexpr size_t kWindow = 1000;
+
+    // sliding window of live ids, old ids retire as new ones come in
+    for (Id id = 0; id < 100 * OrderTable::kPageSize; ++id)
+    {
+        auto [order, inserted] = orderTable.Emplace(id, Order{ id, Side::Bid, 10.0, 5 });
+        EXPECT_TRUE(inserted);
+        EXPECT_EQ(order->mId, id);
+        if (id >= kWindow)
+        {
+            orderTable.Erase(id - kWindow);
+            EXPECT_EQ(orderTable.Find(id - kWindow), nullptr);
+        }
+    }
+    EXPECT_EQ(orderTable.Size(), kWindow);
+    EXPECT_LE(orderTable.GetPageCount(), 3);
+
+    // ids of retired pages cannot come back
+    EXPECT_FALSE(orderTable.Emplace(0, Order{}).second);
+    EXPECT_EQ(orderTable.Find(0), nullptr);
+    EXPECT_EQ(orderTable.Find(100 * OrderTable::kPageSize), nullptr);
+
+    Id last = 100 * OrderTable::kPageSize - 1;
+    ASSERT_NE(orderTable.Find(last), nullptr);
+    EXPECT_EQ(orderTable.Find(last)->mId, last);
+}
+
+TEST(OrderTableTest, KeepsPagesWithLiveOrders)
+{
+    OrderTable orderTable;
+    EXPECT_TRUE(orderTable.Emplace(7, Order{ 7, Side::Ask, 10.0, 5 }).second);
+    for (Id id = 8; id < 10 * OrderTable::kPageSize; ++id)
+    {
+        EXPECT_TRUE(orderTable.Emplace(id, Order{ id, Side::Ask, 10.0, 5 }).second);
+        orderTable.Erase(id);
+    }
+    ASSERT_NE(orderTable.Find(7), nullptr);
+    EXPECT_EQ(orderTable.Find(7)->mVolume, 5);
+    EXPECT_EQ(orderTable.Size(), 1);
+}
+
+TEST(DenseOrderBookTest, MatchOrders)
+{
+    DenseOrderBook orderBook;
+    std::vector<Volume> volumes;
+    orderBook.SetOnTradeCallback([&](const Order&, const Order&, Volume volume, Price, Side){ volumes.push_back(volume); });
+
+    EXPECT_TRUE(orderBook.AddOrder(Side::Bid, 10.7 /*=price*/, 5 /*=volume*/));
+    EXPECT_TRUE(orderBook.AddOrder(Side::Bid, 11 /*=price*/, 5 /*=volume*/));
+    EXPECT_TRUE(orderBook.ModifyOrder(0 /*=id*/, 10.8 /*=price*/, 6 /*=volume*/));
+    EXPECT_EQ(orderBook.FindOrder(0 /*=id*/), nullptr);
+    ASSERT_NE(orderBook.FindOrder(2 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.FindOrder(2 /*=id*/)->mPrice, 10.8);
+
+    EXPECT_TRUE(orderBook.AddOrder(Side::Ask, 7 /*=price*/, 11 /*=volume*/));
+    EXPECT_EQ(volumes, std::vector<Volume>({ 5, 6 }));
+    EXPECT_EQ(orderBook.FindOrder(1 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.FindOrder(2 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.FindOrder(3 /*=id*/), nullptr);
+}
+
+TEST(RiskCheckerTest, RejectsBeforeReachingBook)
+{
+    OrderBook orderBook;
+    RiskChecker riskChecker(2 /*=accounts*/, 0.1 /*=priceBand*/);
+    riskChecker.SetLimits(0, RiskLimits{ 100 /*=maxOrderVolume*/, 5000 /*=maxOrderNotional*/, 150 /*=maxPosition*/, 20000 /*=creditLimit*/, 30 /*=maxSweepVolume*/ });
+
+    EXPECT_EQ(riskChecker.Check(orderBook, 1, Side::Bid, 100, 10), RiskResult::MaxVolume);
+    EXPECT_EQ(riskChecker.Check(orderBook, 2, Side::Bid, 100, 10), RiskResult::UnknownAccount);
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 100, 101), RiskResult::MaxVolume);
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 100, 60), RiskResult::MaxNotional);
+
+    // no reference price yet, no band
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 10, 10), RiskResult::Accepted);
+
+    // BBO mid=100
+    EXPECT_TRUE(orderBook.AddOrder(Side::Bid, 99 /*=price*/, 20 /*=volume*/));
+    EXPECT_TRUE(orderBook.AddOrder(Side::Ask, 101 /*=price*/, 20 /*=volume*/));
+    EXPECT_TRUE(orderBook.AddOrder(Side::Ask, 102 /*=price*/, 20 /*=volume*/));
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 89, 10), RiskResult::PriceBand);
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Ask, 111, 10), RiskResult::PriceBand);
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 91, 10), RiskResult::Accepted);
+
+    // would sweep 40 through both ask levels
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 102, 40), RiskResult::MaxSweepVolume);
+    EXPECT_EQ(riskChecker.Check(orderBook, 0, Side::Bid, 101, 40), RiskResult::Accepted);
+
+    // rejects never reach the book
+    EXPECT_EQ(orderBook.FindOrder(3 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.GetSweepVolume(Side::Bid, 102), 40);
+}
+
+TEST(RiskCheckerTest, TracksPositionAndCredit)
+{
+    OrderBook orderBook;
+    RiskChecker riskChecker(2 /*=accounts*/, 0.1 /*=priceBand*/);
+    RiskCheckedOrderBook riskCheckedOrderBook(orderBook, riskChecker);
+    riskChecker.SetLimits(0, RiskLimits{ 100, 10000, 50 /*=maxPosition*/, 4500 /*=creditLimit*/, 100 });
+    riskChecker.SetLimits(1, RiskLimits{ 100, 10000, 100, 100000, 100 });
+
+    // open orders count towards the position and the credit
+    auto [result, first] = riskCheckedOrderBook.AddOrder(0, Side::Bid, 100 /*=price*/, 30 /*=volume*/);
+    EXPECT_EQ(result, RiskResult::Accepted);
+    EXPECT_EQ(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 30).first, RiskResult::MaxPosition);
+    auto second = riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 10).second;
+    ASSERT_TRUE(second);
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 4000);
+
+    // cancels release the open exposure
+    EXPECT_TRUE(riskCheckedOrderBook.DeleteOrder(*second));
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 3000);
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 10).second);
+
+    // fills move open exposure into the position
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(1, Side::Ask, 100, 40).second);
+    EXPECT_EQ(riskChecker.GetPosition(0), 40);
+    EXPECT_EQ(riskChecker.GetPosition(1), -40);
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 4000);
+    EXPECT_EQ(riskChecker.GetLastTradePrice(), 100);
+    EXPECT_EQ(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 11).first, RiskResult::MaxPosition);
+    EXPECT_EQ(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 10).first, RiskResult::CreditLimit);
+
+    // selling the long position does not use up credit, once filled it frees it
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(0, Side::Ask, 100, 40).second);
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 4000);
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(1, Side::Bid, 100, 40).second);
+    EXPECT_EQ(riskChecker.GetPosition(0), 0);
+    EXPECT_EQ(riskChecker.GetPosition(1), 0);
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 0);
+    EXPECT_EQ(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 45).first, RiskResult::Accepted);
+
+    // last trade takes over as band reference
+    EXPECT_EQ(riskCheckedOrderBook.AddOrder(1, Side::Ask, 111, 10).first, RiskResult::PriceBand);
+    EXPECT_EQ(orderBook.GetBestAsk(), std::nullopt);
+}
+
+TEST(RiskCheckerTest, ModifyMovesExposureToNewId)
+{
+    OrderBook orderBook;
+    RiskChecker riskChecker(2 /*=accounts*/, 0.1 /*=priceBand*/);
+    RiskCheckedOrderBook riskCheckedOrderBook(orderBook, riskChecker);
+    riskChecker.SetLimits(0, RiskLimits{ 100, 10000, 50 /*=maxPosition*/, 100000, 100 });
+    riskChecker.SetLimits(1, RiskLimits{ 100, 10000, 100, 100000, 100 });
+
+    auto id = riskCheckedOrderBook.AddOrder(0, Side::Bid, 100 /*=price*/, 40 /*=volume*/).second;
+    ASSERT_TRUE(id);
+
+    // the replacement is checked net of the order it replaces (40 + 45 would be over 50)
+    EXPECT_EQ(riskCheckedOrderBook.ModifyOrder(*id, 100 /*=price*/, 51 /*=volume*/).first, RiskResult::MaxPosition);
+    EXPECT_EQ(riskCheckedOrderBook.ModifyOrder(*id, 100 /*=price*/, 101 /*=volume*/).first, RiskResult::MaxVolume);
+    auto [result, newId] = riskCheckedOrderBook.ModifyOrder(*id, 100 /*=price*/, 45 /*=volume*/);
+    EXPECT_EQ(result, RiskResult::Accepted);
+    ASSERT_TRUE(newId);
+    EXPECT_EQ(riskChecker.FindOpenOrder(*id), nullptr);
+    ASSERT_NE(riskChecker.FindOpenOrder(*newId), nullptr);
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 4500);
+    EXPECT_EQ(riskCheckedOrderBook.ModifyOrder(*id, 100, 10).first, RiskResult::UnknownOrder);
+
+    // fills on the new id count towards the position
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(1, Side::Ask, 100, 45).second);
+    EXPECT_EQ(riskChecker.GetPosition(0), 45);
+    EXPECT_EQ(riskChecker.GetPosition(1), -45);
+    EXPECT_EQ(riskChecker.GetUsedCredit(0), 4500);
+    EXPECT_EQ(riskChecker.FindOpenOrder(*newId), nullptr);
+    EXPECT_EQ(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100, 6).first, RiskResult::MaxPosition);
+}
+
+TEST(RiskCheckerTest, OpenOrdersWithinCapacityDoNotAllocate)
+{
+    RiskChecker riskChecker(1 /*=accounts*/, 0.1 /*=priceBand*/, 5000 /*=openOrders*/);
+    size_t allocationsBefore = GetAllocationCount();
+    for (Id id = 0; id < 4000; ++id)
+    {
+        riskChecker.OnOrderAdded(0, id, Side::Bid, 100 /*=price*/, 5 /*=volume*/);
+        if (id >= 100)
+        {
+            riskChecker.OnOrderDeleted(id - 100);
+        }
+    }
+    EXPECT_EQ(GetAllocationCount() - allocationsBefore, 0);
+}
+
+template<class Book>
+std::vector<std::tuple<Id, Id, Volume>> MatchAgainstLevel(Book& orderBook, std::vector<Volume> restingVolumes, Volume volume)
+{
+    std::vector<std::tuple<Id, Id, Volume>> trades;
+    orderBook.SetOnTradeCallback([&](const Order& bidOrder, const Order& askOrder, Volume matchVolume, Price, Side)
+    {
+        trades.emplace_back(bidOrder.mId, askOrder.mId, matchVolume);
+    });
+    for (auto restingVolume : restingVolumes)
+    {
+        orderBook.AddOrder(Side::Ask, 100 /*=price*/, restingVolume);
+    }
+    orderBook.AddOrder(Side::Bid, 100 /*=price*/, volume);
+    return trades;
+}
+
+TEST(MatchingPolicyTest, ProRata)
+{
+    using Trades = std::vector<std::tuple<Id, Id, Volume>>;
+    ProRataOrderBook orderBook;
+    EXPECT_EQ(MatchAgainstLevel(orderBook, { 10, 30, 60 }, 50), Trades({ { 3, 0, 5 }, { 3, 1, 15 }, { 3, 2, 30 } }));
+    EXPECT_EQ(orderBook.FindOrder(0 /*=id*/)->mVolume, 5);
+    EXPECT_EQ(orderBook.FindOrder(1 /*=id*/)->mVolume, 15);
+    EXPECT_EQ(orderBook.FindOrder(2 /*=id*/)->mVolume, 30);
+    EXPECT_EQ(orderBook.FindOrder(3 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.GetSweepVolume(Side::Bid, 100 /*=price*/), 50);
+}
+
+TEST(MatchingPolicyTest, ProRataRounding)
+{
+    using Trades = std::vector<std::tuple<Id, Id, Volume>>;
+    ProRataOrderBook orderBook;
+    // cumulative targets ceil(2/3)=1, ceil(4/3)=2, 2: the rounding lots go to the oldest orders
+    EXPECT_EQ(MatchAgainstLevel(orderBook, { 1, 1, 1 }, 2), Trades({ { 3, 0, 1 }, { 3, 1, 1 } }));
+    ASSERT_NE(orderBook.FindOrder(2 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.FindOrder(2 /*=id*/)->mVolume, 1);
+    EXPECT_EQ(orderBook.GetSweepVolume(Side::Bid, 100 /*=price*/), 1);
+}
+
+TEST(MatchingPolicyTest, ProRataLargerThanLevel)
+{
+    using Trades = std::vector<std::tuple<Id, Id, Volume>>;
+    ProRataOrderBook orderBook;
+    EXPECT_EQ(MatchAgainstLevel(orderBook, { 10, 30 }, 50), Trades({ { 2, 0, 10 }, { 2, 1, 30 } }));
+    ASSERT_NE(orderBook.FindOrder(2 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.FindOrder(2 /*=id*/)->mVolume, 10);
+    EXPECT_EQ(orderBook.GetBestBid(), 100);
+    EXPECT_EQ(orderBook.GetBestAsk(), std::nullopt);
+}
+
+TEST(MatchingPolicyTest, TopOrderProRata)
+{
+    using Trades = std::vector<std::tuple<Id, Id, Volume>>;
+    TopOrderProRataOrderBook orderBook;
+    // 40 left for { 30, 60 }: cumulative targets ceil(13.3)=14 and 40, the rounding lot goes to the older order
+    EXPECT_EQ(MatchAgainstLevel(orderBook, { 10, 30, 60 }, 50), Trades({ { 3, 0, 10 }, { 3, 1, 14 }, { 3, 2, 26 } }));
+    EXPECT_EQ(orderBook.FindOrder(0 /*=id*/), nullptr);
+    EXPECT_EQ(orderBook.FindOrder(1 /*=id*/)->mVolume, 16);
+    EXPECT_EQ(orderBook.FindOrder(2 /*=id*/)->mVolume, 34);
+}
+
+// unique per test process, and removed up front in case a crashed run left it behind
+std::string ShmTestName(const std::string& test)
+{
+    std::string name = "/matching_engine_test_" + test + "_" + std::to_string(getpid());
+    shm_unlink(name.c_str());
+    return name;
+}
+
+TEST(ShmRingTest, PublishesBookUpdatesAndTrades)
+{
+    const std::string name = ShmTestName("book");
+    ShmRingWriter writer(name, 64 /*=capacity*/);
+    ASSERT_TRUE(writer.IsOpen());
+    ShmRingReader reader(name);
+    ASSERT_TRUE(reader.IsOpen());
+
+    OrderBook orderBook;
+    PublishMarketData(orderBook, writer);
+    EXPECT_TRUE(orderBook.AddOrder(Side::Ask, 100 /*=price*/, 10 /*=volume*/));
+    EXPECT_TRUE(orderBook.AddOrder(Side::Bid, 101 /*=price*/, 4 /*=volume*/));  // fully filled, never rests
+    EXPECT_TRUE(orderBook.AddOrder(Side::Bid, 100 /*=price*/, 10 /*=volume*/)); // rests with 4 after the fill
+    EXPECT_TRUE(orderBook.AddOrder(Side::Ask, 99 /*=price*/, 4 /*=volume*/));   // trades at the resting price
+
+    std::vector<MarketDataRecord> records;
+    MarketDataRecord record;
+    while (reader.Read(record) == ReadResult::Ok)
+    {
+        records.push_back(record);
+    }
+    ASSERT_EQ(records.size(), 8);
+    EXPECT_EQ(records[0].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[0].mSide, Side::Ask);
+    EXPECT_EQ(records[0].mVolume, 10);
+    EXPECT_EQ(records[1].mType, RecordType::Trade);
+    EXPECT_EQ(records[1].mSide, Side::Bid);
+    EXPECT_EQ(records[1].mBidId, 1);
+    EXPECT_EQ(records[1].mAskId, 0);
+    EXPECT_EQ(records[1].mPrice, 100);
+    EXPECT_EQ(records[1].mVolume, 4);
+    EXPECT_EQ(records[2].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[2].mSide, Side::Ask);
+    EXPECT_EQ(records[2].mVolume, 6);
+    EXPECT_EQ(records[3].mType, RecordType::Trade);
+    EXPECT_EQ(records[3].mVolume, 6);
+    EXPECT_EQ(records[4].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[4].mSide, Side::Ask);
+    EXPECT_EQ(records[4].mVolume, 0);
+
+    // the aggressive bid level only shows up once matching is done and it rests
+    EXPECT_EQ(records[5].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[5].mSide, Side::Bid);
+    EXPECT_EQ(records[5].mPrice, 100);
+    EXPECT_EQ(records[5].mVolume, 4);
+
+    EXPECT_EQ(records[6].mType, RecordType::Trade);
+    EXPECT_EQ(records[6].mSide, Side::Ask);
+    EXPECT_EQ(records[6].mBidId, 2);
+    EXPECT_EQ(records[6].mAskId, 3);
+    EXPECT_EQ(records[6].mPrice, 100);
+    EXPECT_EQ(records[7].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[7].mSide, Side::Bid);
+    EXPECT_EQ(records[7].mVolume, 0);
+}
+
+TEST(ShmRingTest, PublishesThroughRiskChecker)
+{
+    const std::string name = ShmTestName("risk");
+    ShmRingWriter writer(name, 64 /*=capacity*/);
+    ASSERT_TRUE(writer.IsOpen());
+    ShmRingReader reader(name);
+    ASSERT_TRUE(reader.IsOpen());
+
+    OrderBook orderBook;
+    RiskChecker riskChecker(2 /*=accounts*/, 0.1 /*=priceBand*/);
+    riskChecker.SetLimits(0, RiskLimits{ 100, 10000, 50, 100000, 100 });
+    riskChecker.SetLimits(1, RiskLimits{ 100, 10000, 50, 100000, 100 });
+    RiskCheckedOrderBook riskCheckedOrderBook(orderBook, riskChecker);
+    PublishMarketData(riskCheckedOrderBook, writer);
+
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(0, Side::Bid, 100 /*=price*/, 10 /*=volume*/).second);
+    EXPECT_TRUE(riskCheckedOrderBook.AddOrder(1, Side::Ask, 100 /*=price*/, 4 /*=volume*/).second);
+
+    // the checker still sees the fill
+    EXPECT_EQ(riskChecker.GetPosition(0), 4);
+    EXPECT_EQ(riskChecker.GetPosition(1), -4);
+
+    std::vector<MarketDataRecord> records;
+    MarketDataRecord record;
+    while (reader.Read(record) == ReadResult::Ok)
+    {
+        records.push_back(record);
+    }
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[0].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[0].mVolume, 10);
+    EXPECT_EQ(records[1].mType, RecordType::Trade);
+    EXPECT_EQ(records[1].mSide, Side::Ask);
+    EXPECT_EQ(records[1].mVolume, 4);
+    EXPECT_EQ(records[2].mType, RecordType::BookUpdate);
+    EXPECT_EQ(records[2].mSide, Side::Bid);
+    EXPECT_EQ(records[2].mVolume, 6);
+}
+
+TEST(ShmRingTest, DetectsOverrun)
+{
+    const std::string name = ShmTestName("overrun");
+    ShmRingWriter writer(name, 8 /*=capacity*/);
+    ShmRingReader reader(name);
+    for (Volume volume = 0; volume < 20; ++volume)
+    {
+        writer.Publish(MarketDataRecord{ RecordType::Trade, Side::Bid, 0, 0, 100, volume });
+    }
+
+    MarketDataRecord record;
+    EXPECT_EQ(reader.Read(record), ReadResult::Overrun);
+    // records 12..19 are still in the ring, the oldest slot is left to the writer
+    EXPECT_EQ(reader.GetLost(), 13);
+    for (Volume volume = 13; volume < 20; ++volume)
+    {
+        EXPECT_EQ(reader.Read(record), ReadResult::Ok);
+        EXPECT_EQ(record.mVolume, volume);
+    }
+    EXPECT_EQ(reader.Read(record), ReadResult::Empty);
+
+    writer.Publish(MarketDataRecord{ RecordType::Trade, Side::Bid, 0, 0, 100, 42 });
+    EXPECT_EQ(reader.Read(record), ReadResult::Ok);
+    EXPECT_EQ(record.mVolume, 42);
+}
+
+TEST(ShmRingTest, ExclusiveWriterAndClose)
+{
+    const std::string name = ShmTestName("close");
+    auto writer = std::make_unique<ShmRingWriter>(name, 8 /*=capacity*/);
+    ASSERT_TRUE(writer->IsOpen());
+    EXPECT_FALSE(ShmRingWriter(name, 8 /*=capacity*/).IsOpen());
+
+    ShmRingReader reader(name);
+    ASSERT_TRUE(reader.IsOpen());
+    writer->Publish(MarketDataRecord{ RecordType::Trade, Side::Bid, 0, 0, 100, 1 });
+    writer.reset();
+
+    // records published before the writer went away are still delivered
+    MarketDataRecord record;
+    EXPECT_EQ(reader.Read(record), ReadResult::Ok);
+    EXPECT_EQ(record.mVolume, 1);
+    EXPECT_EQ(reader.Read(record), ReadResult::Closed);
+
+    // the name is free again for the next writer
+    EXPECT_TRUE(ShmRingWriter(name, 8 /*=capacity*/).IsOpen());
+}
+
+TEST(ShmRingTest, MultipleReaderProcesses)
+{
+    const std::string name = ShmTestName("processes");
+    constexpr int kReaders = 3;
+    constexpr Volume kRecords = 100000;
+    ShmRingWriter writer(name, 1024 /*=capacity*/);
+    ASSERT_TRUE(writer.IsOpen());
+
+    std::vector<pid_t> readers;
+    for (int i = 0; i < kReaders; ++i)
+    {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0)
+        {
+            // every reader sees records in order and accounts for everything it missed as lost
+            ShmRingReader reader(name, false /*=fromLatest*/);
+            if (!reader.IsOpen())
+            {
+                _exit(2);
+            }
+            Volume start = reader.GetCursor();
+            Volume received = 0;
+            MarketDataRecord record;
+            while (reader.GetCursor() < kRecords)
+            {
+                auto result = reader.Read(record);
+                if (result == ReadResult::Ok)
+                {
+                    if (record.mVolume != reader.GetCursor() - 1)
+                    {
+                        _exit(1);
+                    }
+                    received++;
+                }
+            }
+            _exit(start + received + reader.GetLost() == kRecords ? 0 : 3);
+        }
+        readers.push_back(pid);
+    }
+
+    for (Volume volume = 0; volume < kRecords; ++volume)
+    {
+        writer.Publish(MarketDataRecord{ RecordType::Trade, Side::Bid, volume, volume, 100, volume });
+    }
+
+    for (pid_t pid : readers)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+}